@@ -0,0 +1,84 @@
+#ifndef BODY_INSPECTOR_HPP
+#define BODY_INSPECTOR_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Simulation;
+
+/**
+ * @brief Sorted, filtered row order for the GUI body table, built off the render thread.
+ *
+ * update() snapshots the columns of every body into a job buffer and hands it to a
+ * worker thread, which computes the sort keys, orders the rows and applies the range
+ * filter. The table keeps drawing the last finished order (with live values) until the
+ * next one arrives, so a refresh never stalls a frame. The worker keeps its previous
+ * permutation and repairs it with a bounded insertion sort, which between refreshes
+ * is close to linear; it falls back to a full sort when too much has changed.
+ */
+class BodyInspector {
+public:
+    enum Column { Id, Mass, PosX, PosY, Speed, Energy, COLUMN_COUNT };
+    static constexpr double REFRESH_INTERVAL = 0.25; // seconds between re-sorts while running
+
+    BodyInspector();
+    ~BodyInspector();
+    BodyInspector(const BodyInspector&) = delete;
+    BodyInspector& operator=(const BodyInspector&) = delete;
+
+    // Collects a finished order and starts a new one if the settings or bodies changed
+    void update(const Simulation& sim, double now);
+
+    void setSort(Column column, bool descending);
+    // Keeps only rows whose sort-column value lies in [lo, hi]
+    void setFilter(bool enabled, float lo, float hi);
+
+    // Body indices in display order; may lag the simulation, so validate against its size
+    const std::vector<std::uint32_t>& getOrder() const { return order; }
+    bool isBusy() const;
+    // Bytes held by the snapshot and sort buffers (as of the worker's last idle point)
+    std::size_t memoryBytes() const;
+
+    // Value shown in a column; shared with the worker so sorting matches the display
+    static float columnValue(Column column, std::uint32_t id, float mass, float x, float y, float vx, float vy);
+
+private:
+    struct Row { float mass, x, y, vx, vy; };
+    struct Settings {
+        Column column = Id;
+        bool descending = false;
+        bool filter = false;
+        float lo = 0.0f, hi = 0.0f;
+    };
+
+    // GUI side
+    Settings settings;
+    bool settingsDirty = true;
+    std::vector<std::uint32_t> order;
+    std::uint64_t requestedVersion = ~std::uint64_t(0);
+    double lastRequest = -1.0;
+
+    // Job handed to the worker; written by the GUI only while the worker is idle
+    std::vector<Row> jobRows;
+    Settings jobSettings;
+
+    // Worker side
+    std::vector<float> keys;
+    std::vector<std::uint32_t> perm;
+    Column permColumn = Id;
+    std::vector<std::uint32_t> built;
+
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    bool busy = false, jobPending = false, resultReady = false, stopping = false;
+    mutable std::size_t idleBytes = 0;
+
+    void workerLoop();
+    void build();
+};
+
+#endif // BODY_INSPECTOR_HPP
@@ -7,18 +7,24 @@
 #include <glm/gtc/type_ptr.hpp>
 #include "Planet.hpp"
 
+class Simulation;
+
 /**
  * @brief Camera class that automatically follows the center of mass (COM) of the planetary system
  * 
  * This camera system provides smooth tracking of the center of mass while allowing
  * manual zoom and pan controls for exploration. The camera smoothly interpolates
  * toward the COM to avoid jitter and provide cinematic visuals.
+ *
+ * Framing statistics are computed once per update without allocating: the system
+ * COM comes from the physics sums, the median distance used for outlier rejection
+ * from a fixed-size sample, and the inlier COM and bounds from one parallel pass.
  */
 class Camera {
 public:
     Camera(float screenWidth, float screenHeight);
 
-    void update(const std::vector<Planet>& planets, float deltaTime);
+    void update(const Simulation& sim, float deltaTime);
     void setZoom(float z);
     void zoomBy(float factor);
     void pan(float dx, float dy);
@@ -26,6 +32,12 @@ public:
     glm::vec2 getPosition() const { return position; }
     float getZoom() const { return zoom; }
     glm::vec2 getTarget() const { return target; }
+    // World-space rectangle covered by the view (NDC [-1,1] on both axes)
+    void getVisibleRect(glm::vec2& lo, glm::vec2& hi) const {
+        const glm::vec2 half(1.0f / zoom);
+        lo = position - half;
+        hi = position + half;
+    }
     void reset();
 
     // Planet following
@@ -47,9 +59,22 @@ private:
     int followedPlanetIndex = -1; // -1 = follow COM, >= 0 = follow specific planet
     float outlierMultiplier = 3.0f; // Exclude bodies farther than m * median distance
 
-    glm::vec2 computeCenterOfMass(const std::vector<Planet>& planets) const;
-    float computeOptimalZoom(const std::vector<Planet>& planets) const;
-    void computeInliers(const std::vector<Planet>& planets, std::vector<size_t>& indices) const;
+    // Median distance is exact up to this many bodies, estimated from a strided sample above
+    static constexpr size_t MEDIAN_SAMPLE = 4096;
+
+    // Per-chunk partial sums of the framing pass
+    struct FramePartial {
+        double massX, massY, mass;
+        float minX, minY, maxX, maxY;             // inlier bounds (radius included)
+        float allMinX, allMinY, allMaxX, allMaxY; // all bodies, fallback if no inliers
+        size_t inliers;
+    };
+    std::vector<float> distanceSample;
+    std::vector<FramePartial> partials;
+
+    // Fills the follow target (inlier COM) and the zoom that frames the inliers
+    void computeFraming(const std::vector<Planet>& planets, glm::vec2 systemCom,
+                        glm::vec2& outTarget, float& outZoom);
 };
 
 #endif // CAMERA_HPP
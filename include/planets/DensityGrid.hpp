@@ -0,0 +1,55 @@
+#ifndef DENSITY_GRID_HPP
+#define DENSITY_GRID_HPP
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Planet.hpp"
+
+/**
+ * @brief Screen-space body-count grid used for level-of-detail rendering.
+ *
+ * Bodies are binned into square cells of a few pixels covering the simulation
+ * viewport, in parallel over the body array. Cells holding more than the sparse
+ * threshold are drawn as a tone-mapped density texture; bodies in the remaining
+ * cells are listed so they can still be drawn as individual sprites.
+ */
+class DensityGrid {
+public:
+    DensityGrid() = default;
+
+    // camPos/zoom follow Camera::getViewMatrix (world -> NDC = (p - camPos) * zoom)
+    void build(const std::vector<Planet>& planets, glm::vec2 camPos, float zoom,
+               int viewportW, int viewportH);
+
+    void setCellSize(int pixels) { cellPx = pixels < 1 ? 1 : pixels; }
+    int getCellSize() const { return cellPx; }
+    void setSparseThreshold(std::uint32_t bodies) { sparseThreshold = bodies; }
+    std::uint32_t getSparseThreshold() const { return sparseThreshold; }
+
+    int getCols() const { return cols; }
+    int getRows() const { return rows; }
+    // Row-major from the bottom-left cell, ready for a GL_R32F upload
+    const std::vector<float>& getDensity() const { return density; }
+    float getMaxDensity() const { return maxDensity; }
+    // Indices of on-screen bodies whose cell is at or below the sparse threshold
+    const std::vector<std::uint32_t>& getSparseBodies() const { return sparseBodies; }
+
+    // Bytes held by the grid and its per-chunk scratch
+    std::size_t memoryBytes() const;
+
+private:
+    int cellPx = 4;
+    std::uint32_t sparseThreshold = 4;
+    int cols = 0, rows = 0;
+    std::vector<float> density;
+    float maxDensity = 0.0f;
+    std::vector<std::uint32_t> sparseBodies;
+
+    // Per-chunk scratch reused between frames
+    std::vector<std::vector<std::uint32_t>> chunkCounts;
+    std::vector<std::vector<std::uint32_t>> chunkSparse;
+    std::vector<std::int32_t> cellOf; // cell per body, -1 when off screen
+};
+
+#endif // DENSITY_GRID_HPP
@@ -0,0 +1,126 @@
+#ifndef DIAGNOSTICS_HPP
+#define DIAGNOSTICS_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Simulation;
+
+/**
+ * @brief Conserved-quantity diagnostics (energy, linear and angular momentum, virial ratio).
+ *
+ * At a fixed wall-clock cadence update() copies the bodies into a job buffer and hands
+ * it to a worker thread, so the frame only pays for the copy. The worker gets the
+ * potential energy from a Barnes-Hut quadtree (cells accepted when size / distance <
+ * theta, with a quadrupole correction) in O(N log N), or an exact pair sum for small
+ * systems, using the same softened pair potential as the force law. Drifts are measured against the
+ * first sample after each (re)initialisation and kept in a ring for plotting.
+ */
+class Diagnostics {
+public:
+    static constexpr int HISTORY = 512;
+    static constexpr std::size_t DIRECT_MAX_BODIES = 1024; // exact pair sum up to here
+
+    struct Sample {
+        double simTime = 0.0;
+        double kinetic = 0.0, potential = 0.0, energy = 0.0;
+        double momentumX = 0.0, momentumY = 0.0, angularMomentum = 0.0; // about the origin
+        double virialRatio = 0.0;   // 2K / |U|, 1 in virial equilibrium
+        double energyDrift = 0.0;   // |E - E0| / |E0|
+        double momentumDrift = 0.0; // |P - P0| / sum m|v|
+        double angularDrift = 0.0;  // |L - L0| / sum m|r x v|
+        std::size_t bodies = 0;
+        float evalMs = 0.0f;
+    };
+
+    Diagnostics();
+    ~Diagnostics();
+    Diagnostics(const Diagnostics&) = delete;
+    Diagnostics& operator=(const Diagnostics&) = delete;
+
+    void setEnabled(bool e) { enabled = e; }
+    bool isEnabled() const { return enabled; }
+    // Wall-clock seconds between evaluations
+    void setInterval(double seconds) { interval = seconds > 0.0 ? seconds : 0.0; }
+    double getInterval() const { return interval; }
+    // Barnes-Hut opening angle; smaller is more accurate and slower
+    void setTheta(float t) { theta = t; }
+    float getTheta() const { return theta; }
+
+    // Collects a finished evaluation and starts the next one when due
+    void update(const Simulation& sim, double now);
+    // Blocks until the current state has been evaluated (end of batch runs)
+    void flush(const Simulation& sim);
+
+    bool hasSample() const { return historyCount > 0; }
+    bool isBusy() const;
+    // Bytes held by the snapshot and tree buffers (as of the worker's last idle point)
+    std::size_t memoryBytes() const;
+    const Sample& getLatest() const { return latest; }
+    // Drift series, oldest first from getHistoryOffset() (for PlotLines)
+    const float* getEnergyHistory() const { return energyHistory; }
+    const float* getMomentumHistory() const { return momentumHistory; }
+    const float* getAngularHistory() const { return angularHistory; }
+    int getHistoryOffset() const { return historyCount < HISTORY ? 0 : historyHead; }
+    int getHistoryCount() const { return historyCount; }
+
+private:
+    struct Body { double m, x, y, vx, vy; };
+    struct Cell {
+        double mass = 0.0, comX = 0.0, comY = 0.0;
+        double qxx = 0.0, qxy = 0.0, qyy = 0.0; // traceless quadrupole about the centre of mass
+        double x0 = 0.0, y0 = 0.0, size = 0.0; // lower-left corner and side of the square
+        std::uint32_t first = 0, count = 0;   // bodies in order
+        std::int32_t child = -1;              // first of four consecutive children, -1 for a leaf
+    };
+    static constexpr std::uint32_t LEAF_BODIES = 8;
+    static constexpr int MAX_DEPTH = 40;
+
+    bool enabled = true;
+    double interval = 0.5;
+    float theta = 0.5f;
+
+    // GUI/main-thread side
+    Sample latest;
+    double lastRequest = -1.0;
+    std::uint64_t lastStepCount = 0;
+    std::size_t lastBodyCount = 0;
+    std::uint32_t generation = 0; // bumped on every restart
+    float energyHistory[HISTORY] = {}, momentumHistory[HISTORY] = {}, angularHistory[HISTORY] = {};
+    int historyHead = 0, historyCount = 0;
+
+    // Job handed to the worker; written only while the worker is idle
+    std::vector<Body> jobBodies;
+    double jobG = 0.0, jobEps = 0.0, jobSimTime = 0.0;
+    float jobTheta = 0.5f;
+    std::uint32_t jobGeneration = 0;
+
+    // Worker side
+    Sample result;
+    std::uint32_t resultGeneration = 0;
+    bool haveReference = false;
+    std::uint32_t referenceGeneration = 0;
+    Sample reference;
+    double momentumScale = 0.0, angularScale = 0.0;
+    std::vector<Cell> cells;
+    std::vector<std::uint32_t> order;
+
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable cv, idle;
+    bool busy = false, jobPending = false, resultReady = false, stopping = false;
+    mutable std::size_t idleBytes = 0;
+
+    void collect();
+    void submit(const Simulation& sim);
+    void workerLoop();
+    void evaluate();
+    double potentialDirect() const;
+    double potentialTree();
+    void buildCell(std::int32_t index, int depth);
+};
+
+#endif // DIAGNOSTICS_HPP
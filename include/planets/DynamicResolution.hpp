@@ -0,0 +1,40 @@
+#ifndef DYNAMIC_RESOLUTION_HPP
+#define DYNAMIC_RESOLUTION_HPP
+
+/**
+ * @brief Picks the scene render scale that keeps the simulation pass within a frame budget.
+ *
+ * Fed with the measured GPU time of the scene passes (see PassTimer), which arrives a
+ * few frames late but never stalls the pipeline. Fill cost grows with pixel count, so
+ * an over-budget pass shrinks the scale by the square root of the overshoot; the scale
+ * recovers in small steps once the pass runs well under budget. A cooldown after every
+ * change keeps it from oscillating.
+ */
+class DynamicResolution {
+public:
+    static constexpr float SCALE_STEP = 0.05f;
+
+    // One measured GPU time of the scene passes, in milliseconds
+    void update(float sceneMs);
+
+    void setEnabled(bool e) { enabled = e; if (!e) scale = 1.0f; }
+    bool isEnabled() const { return enabled; }
+    void setTargetMs(float ms) { targetMs = ms > 0.5f ? ms : 0.5f; }
+    float getTargetMs() const { return targetMs; }
+    void setMinScale(float s) { minScale = s < 0.25f ? 0.25f : (s > 1.0f ? 1.0f : s); }
+    float getMinScale() const { return minScale; }
+
+    float getScale() const { return enabled ? scale : 1.0f; }
+    // Smoothed GPU time of the scene passes, in milliseconds (0 until the first result)
+    float getPassMs() const { return smoothedMs; }
+
+private:
+    bool enabled = true;
+    float targetMs = 12.0f; // leaves headroom for UI and swap in a 60 Hz frame
+    float minScale = 0.5f;
+    float scale = 1.0f;
+    float smoothedMs = 0.0f;
+    int cooldown = 0;
+};
+
+#endif // DYNAMIC_RESOLUTION_HPP
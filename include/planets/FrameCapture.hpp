@@ -0,0 +1,79 @@
+#ifndef FRAME_CAPTURE_HPP
+#define FRAME_CAPTURE_HPP
+
+#include <glad/glad.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ImageWriter.hpp"
+#include "MemoryTracker.hpp"
+
+/**
+ * @brief Asynchronous framebuffer capture to image/video files.
+ *
+ * Each capture() issues glReadPixels into the next pixel-pack buffer of a small ring
+ * and returns immediately; the pixels are mapped a few frames later, once the fence
+ * for that readback has signalled, so the GL pipeline never stalls on the transfer.
+ * Mapped frames are copied into pooled buffers and handed to a writer thread that
+ * encodes them with ImageSequenceWriter. The pool bounds memory: if the writer falls
+ * behind, capture waits rather than dropping frames.
+ */
+class FrameCapture {
+public:
+    static constexpr int PBO_COUNT = 3;
+    static constexpr int POOL_SIZE = 8;
+
+    FrameCapture() = default;
+    ~FrameCapture() { finish(); }
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    bool start(const std::string& path, int width, int height, int fps);
+    // Reads back the current read framebuffer (rows bottom-up) of the capture size
+    void capture(GLuint framebuffer);
+    // Drains in-flight readbacks, flushes the writer and closes the output
+    void finish();
+
+    bool isActive() const { return active; }
+    std::size_t getFramesCaptured() const { return framesCaptured; }
+    // Readbacks still in flight on the GPU, and frames waiting for the writer
+    int getPendingReadbacks() const { return pending; }
+    std::size_t getWriterQueueDepth();
+    // Frame pool and readback buffers (the writer's encoder scratch is not included)
+    void collectMemory(MemoryTracker::Report& report) const;
+
+private:
+    struct Frame {
+        std::vector<std::uint8_t> pixels;
+    };
+
+    bool active = false;
+    int width = 0, height = 0;
+    std::size_t frameBytes = 0;
+    std::size_t framesCaptured = 0;
+
+    // GL side: PBO ring; the oldest pending readback sits `pending` slots behind head
+    GLuint pbos[PBO_COUNT] = {};
+    GLsync fences[PBO_COUNT] = {};
+    int head = 0;
+    int pending = 0;
+
+    // Writer side
+    ImageSequenceWriter writer;
+    std::thread writerThread;
+    std::mutex mutex;
+    std::condition_variable queueCv, freeCv;
+    std::deque<Frame*> queue;
+    std::vector<Frame*> freeFrames;
+    std::vector<Frame> pool;
+    bool stopping = false;
+
+    void retireOldest(bool wait);
+    void writerLoop();
+};
+
+#endif // FRAME_CAPTURE_HPP
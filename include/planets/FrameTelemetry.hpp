@@ -0,0 +1,95 @@
+#ifndef FRAME_TELEMETRY_HPP
+#define FRAME_TELEMETRY_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Frame-pacing telemetry: per-frame times in a fixed ring, with percentiles and hitches.
+ *
+ * Each drawn frame records its interval since the previous present, the time spent in
+ * physics and in rendering, and an input-to-present latency estimate. Events are polled
+ * right after each present, so input read at the start of a frame waited on average half
+ * the previous interval before being seen; the estimate adds that to the frame's own time
+ * up to its present (GPU queueing and scan-out are not visible from here). Frames that are
+ * skipped (render on demand, minimized) break the interval chain instead of showing up as
+ * one long frame. A hitch is a frame interval above HITCH_FACTOR times the recent median.
+ */
+class FrameTelemetry {
+public:
+    static constexpr int CAPACITY = 1024; // frames kept
+    static constexpr float HITCH_FACTOR = 2.0f;
+
+    enum Channel { Frame, Physics, Render, Latency, CHANNEL_COUNT };
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        float avgMs = 0.0f, p50Ms = 0.0f, p95Ms = 0.0f, p99Ms = 0.0f, maxMs = 0.0f;
+    };
+
+    FrameTelemetry();
+
+    // Brackets a drawn frame: beginFrame right after input was polled, endFrame after present
+    void beginFrame();
+    void endFrame();
+    // Drops the frame in progress; the next frame starts a new interval chain
+    void discardFrame();
+
+    // Adds the enclosing scope's time to a channel of the current frame
+    class Scope {
+    public:
+        Scope(FrameTelemetry& t, Channel c) : telemetry(t), channel(c), start(Clock::now()) {}
+        ~Scope() { telemetry.add(channel, Clock::now() - start); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        FrameTelemetry& telemetry;
+        Channel channel;
+        Clock::time_point start;
+    };
+    void add(Channel c, Clock::duration d);
+
+    static const char* channelName(Channel c);
+    int getCount() const { return count; }
+    // Oldest first from getOffset(), for PlotLines
+    const float* getHistory(Channel c) const { return history[c]; }
+    int getOffset() const { return count < CAPACITY ? 0 : head; }
+    float getLastMs(Channel c) const { return count > 0 ? history[c][(head + CAPACITY - 1) % CAPACITY] : 0.0f; }
+
+    // Over the frames in the ring
+    Stats getStats(Channel c) const;
+    int getRecentHitches() const;
+    // Since construction or reset()
+    std::uint64_t getTotalFrames() const { return totalFrames; }
+    std::uint64_t getTotalHitches() const { return totalHitches; }
+    void reset();
+
+    // Writes the ring, oldest frame first, one row per frame
+    bool exportCsv(const std::string& path) const;
+    // One line per channel with avg/p50/p95/p99/max, e.g. for batch output
+    std::string summary() const;
+
+private:
+    float history[CHANNEL_COUNT][CAPACITY];
+    bool hitch[CAPACITY];
+    std::uint64_t frameIndex[CAPACITY];
+    int head = 0, count = 0;
+    std::uint64_t totalFrames = 0, totalHitches = 0;
+
+    // Frame in progress
+    bool inFrame = false;
+    Clock::time_point frameStart, lastPresent;
+    bool haveLastPresent = false;
+    float prevIntervalMs = 0.0f;
+    float current[CHANNEL_COUNT] = {};
+
+    // Hitch threshold from the ring median, refreshed every MEDIAN_REFRESH frames
+    static constexpr int MEDIAN_REFRESH = 32;
+    float medianFrameMs = 0.0f;
+    int framesSinceMedian = 0;
+
+    int sortedChannel(Channel c, float* out) const;
+};
+
+#endif // FRAME_TELEMETRY_HPP
@@ -2,11 +2,16 @@
 #define GUI_HPP
 
 #include <GLFW/glfw3.h>
-#include <deque>
 #include "planets/Simulation.hpp"
 #include "Camera.hpp"
+#include "Picker.hpp"
+#include "BodyInspector.hpp"
+#include "MemoryTracker.hpp"
+#include "FrameTelemetry.hpp"
+#include "Diagnostics.hpp"
 
 class Renderer; // forward declaration
+class Profiler;
 
 /**
  * @brief GUI overlay for simulation control and statistics display
@@ -18,10 +23,6 @@ private:
     bool visible = true;
     static constexpr int PANEL_WIDTH = 320;
     
-    // FPS tracking
-    std::deque<float> fpsHistory;
-    static constexpr size_t FPS_HISTORY_SIZE = 100;
-    
     // Control state
     bool isPaused = false;
     float timeScale = 1.0f;
@@ -33,8 +34,8 @@ private:
     float softeningMultiplier = 1.0f;
     
     // Stats
+    int imguiPass = -1; // PassTimer id of the ImGui draw
     int lastPlanetCount = 0;
-    float lastFPS = 0.0f;
 
 public:
     GUI();
@@ -56,6 +57,13 @@ public:
     bool wantsCaptureKeyboard() const;
     bool wantsCaptureMouse() const;
     
+    // Hover and multi-select state to display; owned by the caller
+    void setSelection(const Selection* s) { selection = s; }
+    // Frame-pacing statistics to display and export; owned by the caller
+    void setTelemetry(FrameTelemetry* t) { telemetry = t; }
+    // Conserved-quantity drifts to display and configure; owned by the caller
+    void setDiagnostics(Diagnostics* d) { diagnostics = d; }
+
     void setPaused(bool paused) { isPaused = paused; }
     void toggleVisibility() { visible = !visible; }
 
@@ -65,6 +73,41 @@ public:
 
 private:
     bool restartTriggered = false;
+    const Selection* selection = nullptr;
+    FrameTelemetry* telemetry = nullptr;
+    Diagnostics* diagnostics = nullptr;
+    BodyInspector inspector;
+    bool inspectorFilter = false;
+    float inspectorLo = 0.0f, inspectorHi = 1.0f;
+    static constexpr int MAX_CUSTOM_BODIES = 1000000;
+    static constexpr size_t MAX_SELECTION_MARKERS = 4096;
+
+    // Hover tooltip, drag box and selection markers over the simulation viewport
+    void drawSelectionOverlay(const Simulation& sim, const Camera& camera);
+    // Sortable, filterable per-body table (rows virtualized with a list clipper)
+    void drawBodyTable(const Simulation& sim, Camera& camera);
+    // Per-scope CPU timings as a tree, with the history of the clicked scope
+    void drawProfiler();
+    void drawProfilerNode(const Profiler& profiler, int node);
+    void drawPerfCounters();
+    int profilerNode = 0;
+    static constexpr const char* TRACE_PATH = "planets_trace.json";
+    // Frame-time plot, percentiles and hitch counts
+    void drawFrameTimes(float deltaTime);
+    static constexpr const char* FRAME_CSV_PATH = "planets_frames.csv";
+    static constexpr int TRACE_FRAMES = 300;
+    // Energy, momentum and virial ratio, with the relative drifts plotted
+    void drawDiagnostics();
+
+    // Live bytes per subsystem, refreshed every MEMORY_REFRESH seconds, plus the
+    // allocation rate per tag over the same interval
+    void drawMemory(const Simulation& sim, const Renderer& renderer);
+    static constexpr double MEMORY_REFRESH = 0.5;
+    MemoryTracker::Report memoryReport;
+    MemoryTracker::Traffic memoryTraffic[MemoryTracker::TAG_COUNT];
+    float allocationRate[MemoryTracker::TAG_COUNT] = {};
+    double memoryUpdated = -1.0;
+    std::uint64_t frameAllocationsStart = 0, lastFrameAllocations = 0;
 };
 
 #endif // GUI_HPP
@@ -0,0 +1,56 @@
+#ifndef IMAGE_WRITER_HPP
+#define IMAGE_WRITER_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+enum class ImageFormat { Raw, Y4M, PNG };
+
+/**
+ * @brief Streams RGBA8 frames to disk as raw RGBA, a Y4M (4:4:4) video or a PNG sequence.
+ *
+ * Has no GL dependency so it can be used from writer threads and GL-free batch
+ * renderers alike. PNGs are written with stored (uncompressed) deflate blocks to
+ * avoid a zlib dependency; re-encode with an external tool if size matters.
+ */
+class ImageSequenceWriter {
+public:
+    ImageSequenceWriter() = default;
+    ~ImageSequenceWriter() { close(); }
+    ImageSequenceWriter(const ImageSequenceWriter&) = delete;
+    ImageSequenceWriter& operator=(const ImageSequenceWriter&) = delete;
+
+    // Picks the format from the extension: .y4m, .png (sequence), anything else raw
+    static ImageFormat formatFromPath(const std::string& path);
+
+    // For PNG the path names the frames: the first %d or %0Nd (e.g. "out/f_%05d.png") is the
+    // frame number, %% is a literal percent and any other % is kept as is; a name without a
+    // number gets "_%05d" inserted before the extension.
+    bool open(const std::string& path, ImageFormat format, int width, int height, int fps);
+    // rows are top-down unless flipY is set (GL readback order)
+    bool writeFrame(const std::uint8_t* rgba, std::size_t strideBytes, bool flipY);
+    void close();
+
+    bool isOpen() const { return format == ImageFormat::PNG ? sequenceOpen : file != nullptr; }
+    std::size_t getFramesWritten() const { return framesWritten; }
+    // Encoder scratch; only meaningful on the thread that writes frames
+    std::size_t memoryBytes() const { return scratch.capacity(); }
+
+private:
+    ImageFormat format = ImageFormat::Raw;
+    std::FILE* file = nullptr;
+    // PNG frame names: namePrefix, the zero-padded frame number, nameSuffix
+    std::string namePrefix, nameSuffix;
+    int frameDigits = 0;
+    bool sequenceOpen = false;
+    int width = 0, height = 0;
+    std::size_t framesWritten = 0;
+    std::vector<std::uint8_t> scratch;
+
+    bool writePng(const std::string& path, const std::uint8_t* rgba, std::size_t strideBytes, bool flipY);
+    bool writeY4mFrame(const std::uint8_t* rgba, std::size_t strideBytes, bool flipY);
+};
+
+#endif // IMAGE_WRITER_HPP
@@ -0,0 +1,61 @@
+#ifndef KERNELS_HPP
+#define KERNELS_HPP
+
+#include <cstddef>
+
+/**
+ * @brief Hot loops compiled once per instruction set and picked at startup.
+ *
+ * Each ISA gets its own translation unit built with matching compiler flags, from one
+ * shared source, so the variants differ only in how the compiler vectorises them. The
+ * scalar table is the reference the others must agree with (up to float rounding from
+ * a different summation order). On first use active() takes the best ISA that CPUID and
+ * the OS (XSAVE state) support and that this build contains; PLANETS_ISA in the
+ * environment or select() overrides that, falling back if the CPU lacks it.
+ *
+ * All arrays are structure-of-arrays floats of length n.
+ */
+namespace kernels {
+
+enum class Isa { Scalar, SSE4, AVX2, AVX512, COUNT };
+
+struct Table {
+    Isa isa;
+    // ax[i] += sum over j != i of G m_j (p_j - p_i) / (|r| (|r|^2 + eps^2)); coincident
+    // bodies exert nothing on each other
+    void (*forces)(const float* x, const float* y, const float* m, float* ax, float* ay, std::size_t n,
+                   float g, float eps2);
+    // Semi-implicit Euler: v += a dt, then p += v dt
+    void (*integrate)(float* x, float* y, float* vx, float* vy, const float* ax, const float* ay, std::size_t n,
+                      float dt);
+    // out = { total mass, sum m x, sum m y, sum m vx, sum m vy } over bodies with m > 0
+    void (*sums)(const float* x, const float* y, const float* vx, const float* vy, const float* m, std::size_t n,
+                 double* out);
+    // Interleaves x and y into n (x, y) pairs in dst
+    void (*packPositions)(const float* x, const float* y, std::size_t n, float* dst);
+};
+
+const char* isaName(Isa isa);
+// Accepts scalar, sse4, avx2, avx512 (any case)
+bool parseIsa(const char* name, Isa& out);
+// Compiled into this build and supported by this CPU
+bool isSupported(Isa isa);
+Isa best();
+// nullptr unless isSupported(isa)
+const Table* table(Isa isa);
+
+// Switches every later call of active(); false (and no change) if unsupported
+bool select(Isa isa);
+const Table& active();
+
+namespace detail {
+// Defined by the per-ISA translation units; nullptr when built without the ISA
+const Table* scalarTable();
+const Table* sse4Table();
+const Table* avx2Table();
+const Table* avx512Table();
+}
+
+}
+
+#endif // KERNELS_HPP
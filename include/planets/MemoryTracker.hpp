@@ -0,0 +1,70 @@
+#ifndef MEMORY_TRACKER_HPP
+#define MEMORY_TRACKER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Memory accounting per subsystem.
+ *
+ * Two views, both keyed by Tag:
+ *  - Live bytes: each subsystem reports what it currently holds (container capacity,
+ *    GPU buffer sizes) into a Report when asked, so nothing is tracked per operation.
+ *  - Allocation traffic: when an executable links the operator new replacement
+ *    (AllocationHooks.cpp, CMake option PLANETS_ALLOCATION_TRACKING) every allocation is
+ *    counted against the tag the calling thread has set with a TagScope, plus a
+ *    per-thread total that lets a caller assert a code path allocates nothing.
+ *
+ * Without the hooks the counters stay at zero and isTracking() is false.
+ */
+class MemoryTracker {
+public:
+    enum Tag { Untagged, Bodies, Trails, SpatialIndex, RenderBuffers, IO, UI, TAG_COUNT };
+
+    struct Report {
+        std::size_t cpu[TAG_COUNT] = {};
+        std::size_t gpu[TAG_COUNT] = {};
+        void addCpu(Tag t, std::size_t bytes) { cpu[t] += bytes; }
+        void addGpu(Tag t, std::size_t bytes) { gpu[t] += bytes; }
+    };
+    struct Traffic {
+        std::uint64_t allocations = 0;
+        std::uint64_t bytes = 0;
+    };
+
+    static const char* tagName(Tag t);
+    static bool isTracking();
+    // "12.3 MB" style
+    static std::string formatBytes(std::size_t bytes);
+    // One line per tag with live CPU/GPU bytes and allocation traffic, e.g. for batch output
+    static std::string summary(const Report& report);
+
+    // Cumulative allocations made under a tag, on all threads
+    static Traffic getTraffic(Tag t);
+    // Allocations made so far by the calling thread
+    static std::uint64_t threadAllocations();
+
+    // Attributes the calling thread's allocations to a tag while in scope
+    class TagScope {
+    public:
+        explicit TagScope(Tag t);
+        ~TagScope();
+        TagScope(const TagScope&) = delete;
+        TagScope& operator=(const TagScope&) = delete;
+    private:
+        Tag previous;
+    };
+
+    // Called by the operator new replacement
+    static void recordAllocation(std::size_t bytes);
+    static void setTracking();
+};
+
+// Bytes held by a container's reserved storage
+template <class C>
+std::size_t capacityBytes(const C& c) {
+    return c.capacity() * sizeof(typename C::value_type);
+}
+
+#endif // MEMORY_TRACKER_HPP
@@ -0,0 +1,79 @@
+#ifndef METRICS_SERVER_HPP
+#define METRICS_SERVER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "Diagnostics.hpp"
+#include "MemoryTracker.hpp"
+
+class Simulation;
+class FrameTelemetry;
+
+/**
+ * @brief Prometheus text-format metrics on a Unix domain socket, for unattended runs.
+ *
+ * The main thread publishes into atomics (step count, sim time, step rate, body count,
+ * queue depths, memory, frame percentiles, conserved-quantity drifts from Diagnostics)
+ * and the server thread formats them on each scrape, so a scrape never takes a lock the
+ * simulation holds. Requests starting with "GET" get an HTTP/1.0 response (curl
+ * --unix-socket, or a Prometheus proxy); any other connection just receives the text.
+ * POSIX only; start() fails with a message elsewhere.
+ */
+class MetricsServer {
+public:
+    static constexpr double REFRESH_INTERVAL = 1.0; // seconds between the heavier updates
+    static constexpr int SEND_TIMEOUT_MS = 500;     // a scrape that stops reading is dropped
+
+    MetricsServer() = default;
+    ~MetricsServer() { stop(); }
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Binds the socket and starts serving. A stale socket at the path is replaced; a live
+    // one, or any other kind of file, makes it fail with getError() set
+    bool start(const std::string& socketPath);
+    void stop();
+    bool isRunning() const { return running; }
+    const std::string& getError() const { return error; }
+
+    // Main thread, every frame: cheap counters. Returns true when the heavier figures
+    // below are due, about once per REFRESH_INTERVAL.
+    bool publish(const Simulation& sim, double now);
+    void publishMemory(const MemoryTracker::Report& report);
+    void publishFrameTimes(const FrameTelemetry& telemetry);
+    void publishCaptureQueue(std::size_t writerQueue, int pendingReadbacks);
+    void publishDiagnostics(const Diagnostics::Sample& sample);
+
+private:
+
+    std::string path;
+    std::string error;
+    bool running = false;
+    int listenFd = -1;
+    std::thread thread;
+    std::atomic<bool> stopping{false};
+
+    // Published values; each read independently by the server thread
+    std::atomic<std::uint64_t> steps{0}, bodies{0};
+    std::atomic<double> simTime{0.0}, stepRate{0.0};
+    std::atomic<double> energy{0.0}, energyError{0.0}, momentumError{0.0}, angularError{0.0}, virialRatio{0.0};
+    std::atomic<bool> diagnosticsValid{false};
+    std::atomic<std::uint64_t> memoryCpu[MemoryTracker::TAG_COUNT] = {};
+    std::atomic<std::uint64_t> memoryGpu[MemoryTracker::TAG_COUNT] = {};
+    std::atomic<double> frameP50{0.0}, frameP95{0.0}, frameP99{0.0};
+    std::atomic<std::uint64_t> frames{0}, hitches{0};
+    std::atomic<std::uint64_t> writerQueueDepth{0};
+    std::atomic<int> readbacksPending{0};
+
+    // Main-thread bookkeeping for the step rate and refresh cadence
+    double lastRefresh = -1.0;
+    std::uint64_t stepsAtRefresh = 0;
+
+    void serveLoop();
+    void serveClient(int fd);
+    std::string format() const;
+};
+
+#endif // METRICS_SERVER_HPP
@@ -0,0 +1,37 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <cstddef>
+#include <type_traits>
+
+/**
+ * @brief Minimal persistent worker pool for data-parallel loops over body arrays.
+ *
+ * forRange splits [0, n) into at most maxChunks() contiguous chunks and runs
+ * fn(begin, end, chunk) on the pool, with the calling thread taking part. The
+ * chunk index is stable within a call, so callers can keep per-chunk scratch
+ * (e.g. partial sums) sized by maxChunks(). Dispatch does not allocate. Nested
+ * or concurrent calls run serially on the caller instead of blocking.
+ */
+namespace parallel {
+
+using RangeFn = void (*)(void* ctx, std::size_t begin, std::size_t end, unsigned chunk);
+
+namespace detail {
+void run(std::size_t n, std::size_t minPerChunk, RangeFn fn, void* ctx);
+}
+
+// Number of chunks a single forRange call may use (pool workers + caller)
+unsigned maxChunks();
+
+template <class F>
+void forRange(std::size_t n, std::size_t minPerChunk, F&& fn) {
+    using Fn = std::remove_reference_t<F>;
+    detail::run(n, minPerChunk,
+        [](void* ctx, std::size_t b, std::size_t e, unsigned c) { (*static_cast<Fn*>(ctx))(b, e, c); },
+        const_cast<void*>(static_cast<const void*>(&fn)));
+}
+
+} // namespace parallel
+
+#endif // PARALLEL_HPP
@@ -0,0 +1,78 @@
+#ifndef PASS_TIMER_HPP
+#define PASS_TIMER_HPP
+
+#include <glad/glad.h>
+#include <chrono>
+
+/**
+ * @brief Per-pass GPU and CPU timing for the render loop.
+ *
+ * Each pass is bracketed by a GL_TIME_ELAPSED query (so passes must not nest) and a
+ * CPU clock. Queries live in a ring of FRAME_LATENCY frames and are read only once
+ * every query of a frame reports available, typically a few frames later, so timing
+ * never stalls the pipeline. If the GPU falls further behind than the ring, GPU
+ * timing is skipped for that frame rather than waited on.
+ */
+class PassTimer {
+public:
+    static constexpr int FRAME_LATENCY = 4;
+    static constexpr int MAX_PASSES = 8;
+
+    PassTimer() = default;
+    PassTimer(const PassTimer&) = delete;
+    PassTimer& operator=(const PassTimer&) = delete;
+
+    // Returns the pass id; the name must outlive the timer (string literal)
+    int addPass(const char* name);
+
+    // Times the enclosing scope as one pass
+    class Scope {
+    public:
+        Scope(PassTimer& t, int p) : timer(t), pass(p) { timer.begin(pass); }
+        ~Scope() { timer.end(pass); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        PassTimer& timer;
+        int pass;
+    };
+
+    // Returns true when a previous frame's GPU results became available
+    bool beginFrame();
+    void begin(int pass);
+    void end(int pass);
+    void endFrame();
+    void destroy();
+
+    int getPassCount() const { return passCount; }
+    const char* getPassName(int pass) const { return passes[pass].name; }
+    // Smoothed milliseconds, for display
+    float getGpuMs(int pass) const { return passes[pass].gpuMs; }
+    float getCpuMs(int pass) const { return passes[pass].cpuMs; }
+    // Raw GPU milliseconds of the most recently resolved frame (0 if not drawn)
+    float getLastGpuMs(int pass) const { return passes[pass].lastGpuMs; }
+
+private:
+    struct Pass {
+        const char* name = "";
+        float gpuMs = 0.0f, cpuMs = 0.0f, lastGpuMs = 0.0f;
+        std::chrono::steady_clock::time_point cpuStart;
+        bool cpuRan = false;
+    };
+    struct FrameSlot {
+        GLuint queries[MAX_PASSES] = {};
+        bool used[MAX_PASSES] = {};
+        bool pending = false;
+    };
+
+    Pass passes[MAX_PASSES];
+    int passCount = 0;
+    FrameSlot frames[FRAME_LATENCY];
+    int current = 0;
+    bool recording = false; // GPU queries for the current frame
+    int activePass = -1;
+
+    bool resolve(FrameSlot& slot);
+};
+
+#endif // PASS_TIMER_HPP
@@ -0,0 +1,93 @@
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Hardware performance counters around the physics kernels (Linux perf_event_open).
+ *
+ * One counter group (cycles, instructions, LLC misses, L1D read misses, branch misses)
+ * is opened for the calling thread, user space only, and left running; a Scope reads
+ * the group once on entry and once on exit, so a region costs two read() calls. Deltas
+ * are accumulated per region together with the work done (pair interactions or body
+ * updates) and rolled into a window about once a second for display. Counters the
+ * PMU cannot provide are left out; if none can be opened (other platforms, containers,
+ * kernel.perf_event_paranoid) the class reports why and every Scope is a no-op.
+ *
+ * Only the thread that called setEnabled(true) is counted.
+ */
+class PerfCounters {
+public:
+    // Benchmark is counted only by planets_bench, one unit of work per timed call
+    enum Region { Forces, Integrate, Benchmark, REGION_COUNT };
+    enum Event { Cycles, Instructions, CacheMisses, L1dMisses, BranchMisses, EVENT_COUNT };
+
+    // Estimated floating-point operations per pair in the force kernel (sqrt and
+    // divide count as one); used for FLOP rates, which perf cannot count portably
+    static constexpr double PAIR_FLOPS = 25.0;
+
+    struct Totals {
+        std::uint64_t values[EVENT_COUNT] = {};
+        std::uint64_t work = 0;  // interactions (Forces), bodies (Integrate) or calls (Benchmark)
+        std::uint64_t nanos = 0; // wall time inside the region
+        std::uint64_t calls = 0;
+    };
+
+    static PerfCounters& get();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Opens the counters on first use; returns false (see getError) if unavailable
+    bool setEnabled(bool e);
+    bool isEnabled() const { return enabled; }
+    bool isAvailable(Event e) const { return index[e] >= 0; }
+    const std::string& getError() const { return error; }
+    static const char* eventName(Event e);
+    static const char* regionName(Region r);
+
+    // Counts the enclosing scope towards a region; work is its interaction/body count
+    class Scope {
+    public:
+        Scope(Region r, std::uint64_t work);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        Region region;
+        std::uint64_t work;
+        bool active;
+        std::uint64_t start[EVENT_COUNT + 1]; // counters, then time
+    };
+
+    // Rolls the display window after windowSeconds; call once per frame
+    void update(double now, double windowSeconds = 1.0);
+    // Last completed window, and everything since enabling or reset()
+    const Totals& getWindow(Region r) const { return window[r]; }
+    const Totals& getTotal(Region r) const { return total[r]; }
+    void reset();
+
+    // One-line summary of a region's totals, e.g. for batch output
+    std::string summary(Region r) const;
+
+private:
+    PerfCounters() = default;
+    bool open();
+    void close();
+    // Reads every counter (scaled for multiplexing) into out[EVENT_COUNT]
+    bool read(std::uint64_t* out) const;
+
+    bool enabled = false;
+    bool opened = false;
+    std::string error;
+    int leader = -1;
+    int fds[EVENT_COUNT] = { -1, -1, -1, -1, -1 };
+    int index[EVENT_COUNT] = { -1, -1, -1, -1, -1 }; // position in the group read, -1 if absent
+    int openedCount = 0;
+
+    Totals current[REGION_COUNT], window[REGION_COUNT], total[REGION_COUNT];
+    double windowStart = -1.0;
+};
+
+#endif // PERF_COUNTERS_HPP
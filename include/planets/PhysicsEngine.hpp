@@ -1,18 +1,31 @@
 #ifndef PHYSICS_ENGINE_HPP
 #define PHYSICS_ENGINE_HPP
 
+#include <algorithm>
 #include <vector>
+#include <cmath>
+#include "Kernels.hpp"
 #include "Planet.hpp"
 
 /**
  * @brief PhysicsEngine class to handle physics calculations for planets.
  * Uses the Newtonian gravity equations as the primary force model.
+ *
+ * Each step gathers the bodies into float arrays (structure of arrays), runs the
+ * dispatched kernels (see Kernels.hpp) on them and writes positions and velocities back.
+ * The arrays keep their capacity, so steady-state steps do not allocate.
  */
 class PhysicsEngine {
 private:
     std::vector<Planet*> bodies;
     double G = 0.05;         // default sim-scale gravity (tunable)
     double softening = 0.02; // default softening (tunable)
+    // System sums kept current by integrate(): total mass, mass-weighted position and momentum
+    double totalMass = 0.0;
+    double massPosX = 0.0, massPosY = 0.0;
+    double momentumX = 0.0, momentumY = 0.0;
+    // Kernel working set, one entry per body
+    std::vector<float> x, y, vx, vy, m, ax, ay;
 
 public:
     PhysicsEngine() = default;
@@ -21,48 +34,84 @@ public:
 
     void addBody(Planet* body) { bodies.push_back(body); }
     void clearBodies() { bodies.clear(); }
+    std::size_t memoryBytes() const {
+        return bodies.capacity() * sizeof(Planet*) +
+               (x.capacity() + y.capacity() + vx.capacity() + vy.capacity() + m.capacity() + ax.capacity() +
+                ay.capacity()) * sizeof(float);
+    }
 
-    void computeForces(const float dt) {
-        // Clear force accumulator for all bodies before computing forces
-        for (Planet* p : bodies) {
-            p->clearForces();
-        }
-        
-        // Compute all gravitational forces and accumulate them
-        const size_t n = bodies.size();
-        for (size_t i = 0; i < n; ++i) {
-            for (size_t j = i + 1; j < n; ++j) {
-                Planet* a = bodies[i];
-                Planet* b = bodies[j];
+    // Recomputes the system sums; call after bodies are added or edited outside integrate()
+    void updateSums() {
+        gather();
+        storeSums();
+    }
+    double getTotalMass() const { return totalMass; }
+    // Centre of mass (origin for a massless system)
+    Vector2 getCenterOfMass() const {
+        if (totalMass <= 0.0) return Vector2(0.0f, 0.0f);
+        return Vector2(static_cast<float>(massPosX / totalMass), static_cast<float>(massPosY / totalMass));
+    }
+    Vector2 getMomentum() const { return Vector2(static_cast<float>(momentumX), static_cast<float>(momentumY)); }
+    // Positions in body order as of the last integrate() or updateSums(), which is every
+    // change the simulation makes; valid for getBodyCount() entries
+    const float* getPositionsX() const { return x.data(); }
+    const float* getPositionsY() const { return y.data(); }
+    std::size_t getBodyCount() const { return bodies.size(); }
 
-                Vector2 r = b->getP() - a->getP();
-                float dist = r.length();
-                float denom = (dist*dist) + static_cast<float>(softening * softening);
-                if (denom == 0.0f) continue;
+    // Potential of one pair under the softened force G m1 m2 / (r^2 + eps^2) used by
+    // computeForces, so that kinetic + potential is the quantity the model conserves
+    static double pairPotential(double g, double eps, double m1m2, double r) {
+        if (eps <= 0.0) return r > 0.0 ? -g * m1m2 / r : 0.0;
+        return -g * m1m2 / eps * std::atan2(eps, r); // = (pi/2 - atan(r/eps)) / eps
+    }
 
-                double forceMag = G * a->getMass() * b->getMass() / static_cast<double>(denom);
-                Vector2 dir = r.normalized();
-                Vector2 forceOnA = dir * forceMag;
+    // Accelerations for the next integrate(); masses and positions are re-read from the
+    // bodies, so edits between steps take effect
+    void computeForces() {
+        gather();
+        const std::size_t n = bodies.size();
+        std::fill(ax.begin(), ax.end(), 0.0f);
+        std::fill(ay.begin(), ay.end(), 0.0f);
+        kernels::active().forces(x.data(), y.data(), m.data(), ax.data(), ay.data(), n, static_cast<float>(G),
+                                 static_cast<float>(softening * softening));
+    }
 
-                // Accumulate forces (dt not used in applyForce anymore)
-                a->applyForce(forceOnA, dt);
-                b->applyForce(-forceOnA, dt);
-            }
-        }
-        
-        // Apply accumulated forces to velocities
-        for (Planet* p : bodies) {
-            p->integrateVelocity(dt);
+    void integrate(const float dt) {
+        // Semi-implicit Euler on the arrays; the system sums are refreshed from the same
+        // arrays so consumers never rescan the bodies
+        const std::size_t n = bodies.size();
+        const kernels::Table& k = kernels::active();
+        k.integrate(x.data(), y.data(), vx.data(), vy.data(), ax.data(), ay.data(), n, dt);
+        for (std::size_t i = 0; i < n; ++i) {
+            bodies[i]->setP(Vector2(x[i], y[i]));
+            bodies[i]->setV(Vector2(vx[i], vy[i]));
         }
+        storeSums();
     }
 
-    void integrate(const float dt) {
-        // Update positions using current velocities (semi-implicit Euler)
-        for (Planet* p : bodies) {
-            p->setP(p->getP() + (p->getV() * dt));
-            p->recordPosition();
+private:
+    void gather() {
+        const std::size_t n = bodies.size();
+        for (std::vector<float>* a : { &x, &y, &vx, &vy, &m, &ax, &ay }) a->resize(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            const Planet& p = *bodies[i];
+            x[i] = p.getP().getX();
+            y[i] = p.getP().getY();
+            vx[i] = p.getV().getX();
+            vy[i] = p.getV().getY();
+            m[i] = p.getMass();
         }
     }
+
+    void storeSums() {
+        double s[5];
+        kernels::active().sums(x.data(), y.data(), vx.data(), vy.data(), m.data(), bodies.size(), s);
+        totalMass = s[0];
+        massPosX = s[1];
+        massPosY = s[2];
+        momentumX = s[3];
+        momentumY = s[4];
+    }
 };
 
-#endif //PHYSICS_ENGINE_HPP
\ No newline at end of file
+#endif //PHYSICS_ENGINE_HPP
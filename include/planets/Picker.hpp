@@ -0,0 +1,57 @@
+#ifndef PICKER_HPP
+#define PICKER_HPP
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+class Simulation;
+class Camera;
+
+/**
+ * @brief Screen- and world-space body queries for mouse interaction.
+ *
+ * All queries go through the simulation's SpatialGrid, so their cost depends on how
+ * many bodies sit near the cursor rather than on N. Screen coordinates are framebuffer
+ * pixels with the origin at the top-left of the window; the viewport is the
+ * simulation's rectangle within it. Screen-space picks use the same sprite size as the
+ * planet shader, so a body is hit wherever it is drawn.
+ */
+class Picker {
+public:
+    void setViewport(float left, float top, float width, float height);
+    void setSpriteScale(float radiusScale) { spriteScale = radiusScale; }
+
+    bool contains(glm::vec2 screen) const;
+    glm::vec2 screenToWorld(const Camera& camera, glm::vec2 screen) const;
+
+    // Body drawn under (or within tolerancePx of) the cursor, or -1
+    int pickNearest(const Simulation& sim, const Camera& camera, glm::vec2 screen, float tolerancePx) const;
+    // As pickNearest, but falls back to the body closest to the cursor in world space
+    // (SpatialGrid::nearest), so it only returns -1 when there are no bodies
+    int pickClosest(const Simulation& sim, const Camera& camera, glm::vec2 screen, float tolerancePx) const;
+    // Bodies whose centres lie in the screen rectangle spanned by a and b
+    void pickRect(const Simulation& sim, const Camera& camera, glm::vec2 a, glm::vec2 b,
+                  std::vector<std::uint32_t>& out) const;
+    // Bodies within a world-space radius of center
+    void pickRadius(const Simulation& sim, glm::vec2 center, float radius, std::vector<std::uint32_t>& out) const;
+
+private:
+    float vpLeft = 0.0f, vpTop = 0.0f, vpWidth = 1.0f, vpHeight = 1.0f;
+    float spriteScale = 80.0f;
+    mutable std::vector<std::uint32_t> candidates;
+};
+
+/**
+ * @brief Mouse interaction state shared between the input loop and the GUI.
+ */
+struct Selection {
+    int hovered = -1;
+    std::vector<std::uint32_t> selected;
+    bool dragging = false;
+    glm::vec2 dragStart{0.0f}, dragEnd{0.0f}; // window coordinates
+
+    void clear() { hovered = -1; selected.clear(); dragging = false; }
+};
+
+#endif // PICKER_HPP
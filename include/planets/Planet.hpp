@@ -2,14 +2,13 @@
 #define PLANET_HPP
 
 #include <iostream>
-#include <deque>
 #include <glm/vec3.hpp>
 #include "Vector2.hpp"
 
 
 /**
- * @brief A Planet class representing a celestial body with position, velocity, speed,
- * and a trail of previous positions for visualization.
+ * @brief A Planet class representing a celestial body with position, velocity and speed.
+ * Trails are sampled separately by TrailRecorder.
  */
 class Planet {
 private:
@@ -20,10 +19,6 @@ private:
     float radius = 1.0f;
     glm::vec3 color = glm::vec3(0.95f, 0.98f, 1.0f);
 
-    // trail of previous positions for visualization
-    std::deque<Vector2> trail;
-    static const std::size_t maxTrailLength = 1000;
-
 public:
     Planet() : v{0.0f, 0.0f}, p{0.0f, 0.0f}, forceAccumulator{0.0f, 0.0f} {}
     Planet(const Vector2& initialV) : v{initialV}, p{0.0f, 0.0f}, forceAccumulator{0.0f, 0.0f} {}
@@ -43,14 +38,6 @@ public:
     const Vector2& getP() const { return p; }
     void setP(const Vector2& newP) { p = newP; }
 
-    void recordPosition() {
-        if (trail.size() >= maxTrailLength) trail.pop_front();
-        trail.push_back(p);
-    }
-
-    const std::deque<Vector2>& getTrail() const { return trail; }
-    void clearTrail() { trail.clear(); }
-
     float getSpeed() const {
         const float vx = v.getX();
         const float vy = v.getY();
@@ -75,7 +62,7 @@ public:
     void printInfo() const {
         std::cout << "Planet Position: (" << p.getX() << ", " << p.getY() << ")\n";
         std::cout << "Planet Velocity: (" << v.getX() << ", " << v.getY() << ")\n";
-        std::cout << "Speed: " << getSpeed() << "  Trail length: " << trail.size() << "\n";
+        std::cout << "Speed: " << getSpeed() << "\n";
     }
 
     const glm::vec3& getColor() const { return color; }
@@ -0,0 +1,106 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include "Tracer.hpp"
+
+/**
+ * @brief Hierarchical CPU profiler for the main loop.
+ *
+ * Scopes opened with PLANETS_PROFILE_SCOPE nest into a tree keyed by name under the
+ * enclosing scope; each frame's time and call count per node is pushed into a ring of
+ * HISTORY frames for the GUI. Recording costs two clock reads and a short child-list
+ * walk per scope, with no allocation: nodes live in a fixed array and scopes past
+ * MAX_NODES are dropped. Only the thread that calls beginFrame() records, so scopes
+ * reached from pool workers cost a thread-local check and nothing else.
+ *
+ * While a Tracer capture records, every scope is also emitted as a trace span, from
+ * any thread. Builds without PLANETS_PROFILING compile the scopes out entirely.
+ */
+class Profiler {
+public:
+    static constexpr int MAX_NODES = 64;
+    static constexpr int HISTORY = 240;
+
+    static Profiler& get();
+
+    void setEnabled(bool e) { enabled = e; }
+    bool isEnabled() const { return enabled; }
+
+    // Frame brackets; a beginFrame without endFrame discards the partial frame
+    void beginFrame();
+    void endFrame();
+
+    // Used by ProfileScope: returns the node entered, or -1 when not recording
+    int enter(const char* name);
+    void leave(int node, std::chrono::steady_clock::duration elapsed);
+
+    struct Stats {
+        float lastMs = 0.0f, minMs = 0.0f, avgMs = 0.0f, p99Ms = 0.0f;
+        std::uint32_t calls = 0; // in the last frame
+    };
+    // Node 0 is the whole frame; children are linked in first-seen order
+    int getNodeCount() const { return nodeCount; }
+    const char* getName(int node) const { return nodes[node].name; }
+    int getFirstChild(int node) const { return nodes[node].firstChild; }
+    int getNextSibling(int node) const { return nodes[node].nextSibling; }
+    Stats getStats(int node) const;
+    // Per-frame milliseconds, oldest first from getHistoryOffset() (for PlotLines)
+    const float* getHistory(int node) const { return nodes[node].history; }
+    int getHistoryOffset() const { return historyCount < HISTORY ? 0 : historyHead; }
+    int getHistoryCount() const { return historyCount; }
+
+private:
+    struct Node {
+        const char* name = "";
+        int parent = -1, firstChild = -1, lastChild = -1, nextSibling = -1;
+        std::chrono::steady_clock::duration frameTime{};
+        std::uint32_t frameCalls = 0, lastCalls = 0;
+        float history[HISTORY] = {};
+    };
+
+    Profiler();
+
+    Node nodes[MAX_NODES];
+    int nodeCount = 1;
+    int current = 0;
+    bool enabled = true;
+    bool inFrame = false;
+    std::chrono::steady_clock::time_point frameStart;
+    int historyHead = 0, historyCount = 0;
+};
+
+// Times the enclosing scope as a child of the innermost open scope
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* n) : name(n), node(Profiler::get().enter(n)), traced(Tracer::recording()) {
+        if (node < 0 && !traced) return;
+        start = std::chrono::steady_clock::now();
+        if (traced) Tracer::get().begin(name, start);
+    }
+    ~ProfileScope() {
+        if (node < 0 && !traced) return;
+        const std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+        if (traced) Tracer::get().end(name, stop);
+        if (node >= 0) Profiler::get().leave(node, stop - start);
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    int node;
+    bool traced;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define PLANETS_PROFILE_CONCAT_(a, b) a##b
+#define PLANETS_PROFILE_CONCAT(a, b) PLANETS_PROFILE_CONCAT_(a, b)
+#ifdef PLANETS_PROFILING
+#define PLANETS_PROFILE_SCOPE(name) ProfileScope PLANETS_PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#else
+#define PLANETS_PROFILE_SCOPE(name) ((void)0)
+#endif
+
+#endif // PROFILER_HPP
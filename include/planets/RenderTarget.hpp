@@ -0,0 +1,37 @@
+#ifndef RENDER_TARGET_HPP
+#define RENDER_TARGET_HPP
+
+#include <glad/glad.h>
+#include <cstddef>
+
+/**
+ * @brief Offscreen colour target: a framebuffer object with an RGBA8 texture attachment.
+ * The texture can be sampled afterwards (e.g. for upscaling) or read back for capture.
+ */
+class RenderTarget {
+public:
+    RenderTarget() = default;
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    // (Re)allocates storage; a no-op when the size is unchanged
+    bool resize(int w, int h);
+    void destroy();
+    void bind() const { glBindFramebuffer(GL_FRAMEBUFFER, fbo); }
+    static void bindDefault() { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+
+    GLuint getFramebuffer() const { return fbo; }
+    GLuint getTexture() const { return color; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    bool isValid() const { return fbo != 0; }
+    std::size_t byteSize() const { return static_cast<std::size_t>(width) * height * 4; }
+
+private:
+    GLuint fbo = 0;
+    GLuint color = 0;
+    int width = 0;
+    int height = 0;
+};
+
+#endif // RENDER_TARGET_HPP
@@ -4,11 +4,24 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <vector>
-#include <deque>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "Planet.hpp"
 #include "Camera.hpp"
+#include "TrailRecorder.hpp"
+#include "Simulation.hpp"
+#include "StreamBuffer.hpp"
+#include "DensityGrid.hpp"
+#include "RenderTarget.hpp"
+#include "DynamicResolution.hpp"
+#include "ShaderCache.hpp"
+#include "PassTimer.hpp"
+#include "MemoryTracker.hpp"
+
+// How planets are drawn: always sprites, always the density LOD, or density once
+// the body count crosses the auto threshold
+enum class PlanetRenderMode { Sprites, Density, Auto };
 
 /**
  * @brief Enhanced OpenGL renderer for planetary simulation with camera, glow effects, and trails
@@ -19,24 +32,97 @@ private:
     int height;
     GLFWwindow* window;
     float cameraZoom = 1.0f;
+    // Headless mode renders into an offscreen target with no visible window
+    bool headless = false;
+    RenderTarget offscreen;
     // Active simulation viewport (in framebuffer pixels, origin bottom-left)
     int vpLeft = 0, vpBottom = 0, vpWidth = 0, vpHeight = 0;
+    // Dynamic resolution: below scale 1 the scene is drawn into sceneTarget and
+    // upscaled into the viewport; UI always draws at native resolution
+    DynamicResolution dynamicResolution;
+    RenderTarget sceneTarget;
+    bool sceneScaled = false;
+    // Per-pass GPU/CPU timing; the scene passes also drive dynamicResolution
+    PassTimer passTimer;
+    int passStarfield = -1, passTrails = -1, passPlanets = -1, passUpscale = -1;
+    // Render-on-demand: window/input events bump eventSerial (callbacks are installed
+    // before ImGui's, which chains to them); frames are redrawn only when it, the sim
+    // state or the camera moved, plus a few settle frames for UI hover/animation
+    static constexpr int REDRAW_SETTLE_FRAMES = 3;
+    std::uint64_t eventSerial = 1;
+    std::uint64_t drawnEventSerial = 0;
+    std::uint64_t drawnStateVersion = 0;
+    std::uint64_t drawnStaticVersion = 0;
+    glm::vec2 drawnCameraPos = glm::vec2(0.0f);
+    float drawnCameraZoom = 0.0f;
+    int settleFrames = 0;
+    static void onWindowEvent(GLFWwindow* win);
     
-    // Planet rendering
+    // Planet rendering: instanced quads. Colour/radius live in a static VBO re-uploaded
+    // only when the simulation's static version moves; positions stream through a fenced ring.
+    struct PlanetStatic {
+        std::uint32_t color; // RGBA8
+        float radius;
+    };
     GLuint planetVAO;
-    GLuint planetVBO;
+    GLuint planetStaticVBO;
+    GLuint planetQuadVBO = 0;
+    StreamBuffer planetPositions;
+    std::uint64_t uploadedStateVersion = 0;
+    std::uint64_t uploadedStaticVersion = 0;
+    size_t uploadedPlanetCount = 0;
+    std::vector<PlanetStatic> planetStatics; // upload scratch, kept for reuse
     GLuint planetShaderProgram;
     GLint loc_uView;
     GLint loc_uRadiusScale;
     GLint loc_uPixelPerWorld;
+    GLint loc_uViewportPx = -1;
+
+    // Subset sprites (LOD sparse cells): packed 16-byte instances streamed per frame
+    struct PlanetInstance {
+        float x, y;
+        std::uint32_t color; // RGBA8
+        float radius;
+    };
+    GLuint planetSubsetVAO = 0;
+    StreamBuffer planetInstances;
+    std::vector<std::uint32_t> visibleBodies; // view-culled indices, reused per frame
+    // What the last subset upload was culled for; while all of it holds (e.g. paused with
+    // a still camera) the uploaded region is redrawn without querying or packing again
+    bool subsetUploaded = false;
+    std::uint64_t subsetStateVersion = 0, subsetStaticVersion = 0;
+    glm::vec2 subsetViewLo{0.0f}, subsetViewHi{0.0f};
+    size_t subsetBodyCount = 0;   // bodies in the simulation at upload
+    size_t subsetInstanceCount = 0;
+
+    // Density LOD
+    PlanetRenderMode planetRenderMode = PlanetRenderMode::Auto;
+    size_t densityAutoThreshold = 50000;
+    DensityGrid densityGrid;
+    GLuint densityTexture = 0;
+    int densityTexCols = 0, densityTexRows = 0;
+    GLuint densityShaderProgram = 0;
+    GLint densityLoc_uGridScale = -1;
+    GLint densityLoc_uLogMax = -1;
+    GLint densityLoc_uSparse = -1;
     
-    // Trail rendering
+    // Trail rendering: visible runs of all trails packed into one stream and multi-drawn
+    struct TrailVertex {
+        float x, y;
+        float age;           // 0 = newest, 1 = oldest
+        std::uint32_t color; // RGBA8
+    };
     GLuint trailVAO;
-    GLuint trailVBO;
+    StreamBuffer trailStream;
+    std::vector<TrailVertex> trailVertices;
+    std::vector<GLint> runFirsts;
+    std::vector<GLsizei> runCounts;
     GLuint trailShaderProgram;
     GLint trailLoc_uView;
-    GLint trailLoc_uColor;
     
+    // Shader programs are built through the binary cache in init()
+    ShaderCache shaderCache;
+
     // Background rendering
     GLuint backgroundVAO;
     GLuint backgroundVBO;
@@ -52,10 +138,8 @@ private:
     glm::vec2 cameraPosition;
     glm::mat4 viewMatrix;
     
-    // Trail system
-    std::vector<std::deque<Vector2>> trails;
+    // Trail drawing toggle (sampling lives in the simulation's TrailRecorder)
     bool trailsEnabled;
-    int maxTrailLength;
     
     // Background toggle
     bool starfieldEnabled;
@@ -63,33 +147,68 @@ private:
     float planetRadiusScale = 80.0f;
     
     void updateViewMatrix();
-    void updateTrails(const std::vector<Planet>& planets);
     void initStarfield();
+    void uploadPlanetStatics(const std::vector<Planet>& planets);
+    bool uploadPlanetPositions(const PhysicsEngine& physics);
+    void setPlanetUniforms(const Camera& camera);
+    bool uploadPlanetSubset(const std::vector<Planet>& planets, const std::vector<std::uint32_t>& indices);
+    void drawPlanetSubset(const Camera& camera);
+    void drawDensity(const std::vector<Planet>& planets, const Camera& camera);
     void drawStarfield();
 
 public:
     Renderer(int w, int h, const char* title);
     
+    // Must be called before init(); renders to an FBO (see getSceneFramebuffer)
+    void setHeadless(bool h) { headless = h; }
+    bool isHeadless() const { return headless; }
     bool init();
     void beginFrame();
+    // Bracket the simulation passes: sets the (possibly scaled) scene viewport, then
+    // upscales into the viewport rect and restores the full-framebuffer viewport
+    void beginScene();
+    void endScene();
     void drawBackground(const Camera& camera);
-    void drawPlanets(const std::vector<Planet>& planets, const Camera& camera);
-    void drawTrails(const std::vector<Planet>& planets, const Camera& camera);
+    void drawPlanets(const Simulation& sim, const Camera& camera);
+    void drawTrails(const TrailRecorder& trails, const std::vector<Planet>& planets, const Camera& camera);
     void endFrame();
+    // Render-on-demand: whether anything visible changed since markDrawn()
+    bool needsRedraw(const Simulation& sim, const Camera& camera) const;
+    void markDrawn(const Simulation& sim, const Camera& camera);
+    // Sleeps until an input/window event or the timeout, instead of drawing a frame
+    void waitEvents(double timeoutSeconds);
+    bool isMinimized() const;
     bool shouldClose();
     void cleanup();
     GLFWwindow* getWindow() const { return window; }
+    // Framebuffer the scene is drawn into (0 = default window framebuffer)
+    GLuint getSceneFramebuffer() const { return headless ? offscreen.getFramebuffer() : 0; }
+    // Blocking RGBA8 readback of the scene framebuffer, rows bottom-up. Stalls until the
+    // GPU is done, so it is for checks only; FrameCapture is the pipelined path.
+    void readScenePixels(std::vector<std::uint8_t>& out) const;
     void setZoom(float zoom);
     void pan(float dx, float dy);
 
     glm::mat4 getViewMatrix() const { return viewMatrix; }
     void setTrailsEnabled(bool enabled) { trailsEnabled = enabled; }
     bool areTrailsEnabled() const { return trailsEnabled; }
-    void clearTrails();
     void handleInput();
     void setViewportRect(int left, int bottom, int width, int height) { vpLeft = left; vpBottom = bottom; vpWidth = width; vpHeight = height; }
     void setPlanetVisualScale(float s) { planetRadiusScale = s; }
     float getPlanetVisualScale() const { return planetRadiusScale; }
+
+    // Level-of-detail control
+    void setPlanetRenderMode(PlanetRenderMode mode) { planetRenderMode = mode; }
+    PlanetRenderMode getPlanetRenderMode() const { return planetRenderMode; }
+    void setDensityAutoThreshold(size_t bodies) { densityAutoThreshold = bodies; }
+    size_t getDensityAutoThreshold() const { return densityAutoThreshold; }
+    DensityGrid& getDensityGrid() { return densityGrid; }
+    DynamicResolution& getDynamicResolution() { return dynamicResolution; }
+    PassTimer& getPassTimer() { return passTimer; }
+    // Configure before init() (shader override directory, binary cache location)
+    ShaderCache& getShaderCache() { return shaderCache; }
+    // CPU scratch and GPU buffers/targets, by size as allocated
+    void collectMemory(MemoryTracker::Report& report) const;
     
     // Background control
     void setStarfieldEnabled(bool enabled) { starfieldEnabled = enabled; }
@@ -0,0 +1,57 @@
+#ifndef SHADER_CACHE_HPP
+#define SHADER_CACHE_HPP
+
+#include <glad/glad.h>
+#include <string>
+
+/**
+ * @brief Builds GL programs from shader sources, caching the linked driver binaries on disk.
+ *
+ * Each program is keyed by a hash of its shader sources and the GL vendor, renderer and
+ * version strings, so edited shaders or a driver update simply miss the cache. Cached
+ * binaries are loaded with glProgramBinary (GL 4.1 / ARB_get_program_binary, resolved at
+ * runtime); a rejected or missing binary falls back to compiling from source, and the
+ * fresh binary is written back. Compile and link errors are reported with their logs.
+ *
+ * When a source directory is set, shader files found there (by file name) replace the
+ * embedded sources, so shaders can be edited without a rebuild; missing files are
+ * written out from the embedded sources first. A file that fails to compile falls
+ * back to the embedded source.
+ */
+class ShaderCache {
+public:
+    struct Source {
+        const char* file;     // file name looked up in the source directory
+        const char* embedded; // built-in source used otherwise
+    };
+
+    ShaderCache();
+
+    // Empty disables the binary cache
+    void setCacheDir(const std::string& dir) { cacheDir = dir; }
+    const std::string& getCacheDir() const { return cacheDir; }
+    // Empty uses only the embedded sources
+    void setSourceDir(const std::string& dir) { sourceDir = dir; }
+    const std::string& getSourceDir() const { return sourceDir; }
+
+    // Returns a linked program, or 0 after reporting why none could be built
+    GLuint getProgram(const char* name, const Source& vs, const Source& fs);
+
+    int getCacheHits() const { return cacheHits; }
+    int getCompiled() const { return compiled; }
+
+private:
+    std::string cacheDir;
+    std::string sourceDir;
+    std::string driverId; // vendor/renderer/version, read on first use
+    int cacheHits = 0;
+    int compiled = 0;
+
+    std::string loadSource(const Source& src, bool& fromFile) const;
+    std::string cachePath(const char* name, const std::string& vs, const std::string& fs);
+    GLuint build(const char* name, const std::string& vs, const std::string& fs);
+    GLuint loadBinary(const std::string& path) const;
+    void storeBinary(const std::string& path, GLuint program) const;
+};
+
+#endif // SHADER_CACHE_HPP
@@ -2,8 +2,12 @@
 #define SIMULATION_HPP
 
 #include <vector>
+#include <cstdint>
+#include "MemoryTracker.hpp"
 #include "PhysicsEngine.hpp"
 #include "Planet.hpp"
+#include "TrailRecorder.hpp"
+#include "SpatialGrid.hpp"
 
 /**
  * Simulation class managing a system of planets with N-body physics.
@@ -12,7 +16,21 @@ class Simulation {
 private:
     PhysicsEngine physics;
     std::vector<Planet> planets;
+    TrailRecorder trails;
     float deltaTime = 0.0015f;
+    double simTime = 0.0;
+    // Bumped on every change to positions (stateVersion) or to colour/radius (staticVersion)
+    std::uint64_t stateVersion = 0;
+    std::uint64_t staticVersion = 0;
+    // Lazily rebuilt spatial index over current positions
+    mutable SpatialGrid spatialIndex;
+    mutable std::uint64_t spatialIndexVersion = ~std::uint64_t(0);
+    // Steps to run before step() must stop allocating; -1 disables the check
+    int allocationWarmup = -1;
+    std::uint64_t stepCount = 0;
+
+    void registerBodies();
+    void allocationCheckFailed(std::uint64_t allocations) const;
 
 public:
     Simulation() = default;
@@ -22,10 +40,40 @@ public:
     void update();
     
     std::vector<Planet>& getPlanets() { return planets; }
+    const std::vector<Planet>& getPlanets() const { return planets; }
     void setTimeStep(float dt) { deltaTime = dt; }
     float getTimeStep() const { return deltaTime; }
     void setGravityParams(float g, float eps) { physics.setGravityParams(g, eps); }
     std::pair<float, float> getGravityParams() const { return physics.getGravityParams(); }
+    double getSimTime() const { return simTime; }
+    // Steps since the bodies were last (re)initialised
+    std::uint64_t getStepCount() const { return stepCount; }
+    // Maintained by the physics integrator, O(1) to query
+    Vector2 getCenterOfMass() const { return physics.getCenterOfMass(); }
+    Vector2 getMomentum() const { return physics.getMomentum(); }
+    double getTotalMass() const { return physics.getTotalMass(); }
+    // Float position arrays kept by the physics engine (see PhysicsEngine::getPositionsX)
+    const PhysicsEngine& getPhysics() const { return physics; }
+
+    // Change tracking for consumers that cache per-body data (e.g. GPU buffers)
+    std::uint64_t getStateVersion() const { return stateVersion; }
+    std::uint64_t getStaticVersion() const { return staticVersion; }
+    // Call after editing planet colour or radius through getPlanets()
+    void markStaticDirty() { ++staticVersion; }
+
+    // Uniform grid over current positions, rebuilt at most once per state change
+    const SpatialGrid& getSpatialIndex() const;
+
+    // Trail sampling (decoupled from the physics substep rate)
+    TrailRecorder& getTrails() { return trails; }
+    const TrailRecorder& getTrails() const { return trails; }
+    void clearTrails() { trails.clear(); }
+
+    // Live bytes of the body store, trails and spatial index
+    void collectMemory(MemoryTracker::Report& report) const;
+    // Aborts if a step allocates on the calling thread once warmupSteps have run
+    // since the last (re)initialisation; needs PLANETS_ALLOCATION_TRACKING
+    void setAllocationCheck(int warmupSteps) { allocationWarmup = warmupSteps; }
 };
 
 #endif //SIMULATION_HPP
\ No newline at end of file
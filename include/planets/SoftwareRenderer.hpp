@@ -0,0 +1,77 @@
+#ifndef SOFTWARE_RENDERER_HPP
+#define SOFTWARE_RENDERER_HPP
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Camera.hpp"
+#include "Simulation.hpp"
+#include "Starfield.hpp"
+#include "MemoryTracker.hpp"
+
+/**
+ * @brief GL-free CPU rasterizer reproducing Renderer's starfield, trails and planet sprites.
+ *
+ * Primitives are binned into 64x64 pixel tiles in submission order, then tiles are
+ * rasterized in parallel, each into a float RGBA scratch buffer that is composited
+ * with SSE (scalar fallback elsewhere) and resolved to RGBA8. Blending and shading
+ * follow the GL shaders (src-alpha / one-minus-src-alpha, same falloff curves), so
+ * output can be compared against a GL readback with compare(). Rows are stored
+ * bottom-up like glReadPixels. The density LOD view is not reproduced.
+ */
+class SoftwareRenderer {
+public:
+    static constexpr int TILE_SIZE = 64;
+
+    struct ImageDiff {
+        int maxAbs = 0;       // largest per-channel difference (0..255)
+        double meanAbs = 0.0; // mean per-channel difference
+        double psnr = 0.0;    // dB, infinity for identical images
+    };
+
+    SoftwareRenderer(int w, int h);
+
+    void resize(int w, int h);
+    void render(const Simulation& sim, const Camera& camera);
+
+    const std::vector<std::uint8_t>& getPixels() const { return pixels; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    // Primitive lists, tile bins, scratch and the output image
+    void collectMemory(MemoryTracker::Report& report) const;
+
+    void setStarfieldEnabled(bool enabled) { starfieldEnabled = enabled; }
+    void setTrailsEnabled(bool enabled) { trailsEnabled = enabled; }
+    void setPlanetVisualScale(float s) { planetRadiusScale = s; }
+
+    // Compares two RGBA8 images of equal size (RGB channels only)
+    static ImageDiff compare(const std::uint8_t* a, const std::uint8_t* b, int w, int h);
+
+private:
+    enum class PrimType : std::uint8_t { Star, Segment, Sprite };
+
+    struct Prim {
+        PrimType type;
+        float x0, y0, x1, y1; // pixel coords; sprites use x1 as half size
+        float a0, a1;         // alpha at each end (segments) or base alpha
+        float r, g, b;
+    };
+
+    int width = 0, height = 0;
+    int tilesX = 0, tilesY = 0;
+    bool starfieldEnabled = true;
+    bool trailsEnabled = true;
+    float planetRadiusScale = 80.0f;
+
+    std::vector<Star> stars;
+    std::vector<Prim> prims;
+    std::vector<std::vector<std::uint32_t>> tileBins;
+    std::vector<std::vector<float>> chunkScratch; // per worker tile colour buffer
+    std::vector<std::uint8_t> pixels;
+
+    void addPrim(const Prim& p, float minX, float minY, float maxX, float maxY);
+    void buildPrims(const Simulation& sim, const Camera& camera);
+    void rasterTile(int tx, int ty, float* tile); // writes only its own tile of pixels
+};
+
+#endif // SOFTWARE_RENDERER_HPP
@@ -0,0 +1,67 @@
+#ifndef SPATIAL_GRID_HPP
+#define SPATIAL_GRID_HPP
+
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <glm/glm.hpp>
+#include "Planet.hpp"
+
+/**
+ * @brief Uniform grid over body positions for view culling and spatial queries.
+ *
+ * Built with a counting sort, so construction is O(N) with no per-cell
+ * allocations: cellStart holds prefix offsets into a body list sorted by cell,
+ * alongside a copy of each body's position for cache-friendly exact tests.
+ * Queries touch only the cells overlapping the query region.
+ */
+class SpatialGrid {
+public:
+    SpatialGrid() = default;
+
+    void build(const std::vector<Planet>& planets);
+
+    bool empty() const { return items.empty(); }
+    std::size_t size() const { return items.size(); }
+    // Bounds of all body positions, and the largest body radius
+    glm::vec2 getMin() const { return boundsMin; }
+    glm::vec2 getMax() const { return boundsMax; }
+    float getMaxRadius() const { return maxRadius; }
+    std::size_t memoryBytes() const;
+
+    // Appends the indices of bodies whose position lies inside [lo, hi]
+    void queryRect(glm::vec2 lo, glm::vec2 hi, std::vector<std::uint32_t>& out) const;
+    // Appends the indices of bodies within radius of center
+    void queryRadius(glm::vec2 center, float radius, std::vector<std::uint32_t>& out) const;
+    // Index of the body closest to p within maxDist, or -1. Searches outward in
+    // growing squares, so the cost depends on local density rather than N.
+    int nearest(glm::vec2 p, float maxDist = std::numeric_limits<float>::max()) const;
+
+    // Calls f(index, position) for every body in the cells overlapping [lo, hi]
+    // (a superset of the bodies inside the rectangle)
+    template <class F>
+    void forEachCandidate(glm::vec2 lo, glm::vec2 hi, F&& f) const {
+        int x0, y0, x1, y1;
+        if (!cellRange(lo, hi, x0, y0, x1, y1)) return;
+        for (int cy = y0; cy <= y1; ++cy) {
+            const std::size_t row = static_cast<std::size_t>(cy) * cols;
+            for (std::size_t k = cellStart[row + x0]; k < cellStart[row + x1 + 1]; ++k) {
+                f(items[k], itemPos[k]);
+            }
+        }
+    }
+
+private:
+    glm::vec2 boundsMin{0.0f}, boundsMax{0.0f};
+    glm::vec2 invCellSize{1.0f};
+    int cols = 0, rows = 0;
+    float maxRadius = 0.0f;
+    std::vector<std::uint32_t> cellStart; // cols*rows + 1 prefix offsets
+    std::vector<std::uint32_t> items;     // body indices sorted by cell
+    std::vector<glm::vec2> itemPos;       // positions in items order
+    std::vector<std::uint32_t> cellOf;    // scratch: cell per body
+
+    bool cellRange(glm::vec2 lo, glm::vec2 hi, int& x0, int& y0, int& x1, int& y1) const;
+};
+
+#endif // SPATIAL_GRID_HPP
@@ -0,0 +1,18 @@
+#ifndef STARFIELD_HPP
+#define STARFIELD_HPP
+
+#include <vector>
+
+/**
+ * @brief Deterministic static starfield shared by the GL and software renderers.
+ * Stars are in NDC ([-1,1] on both axes) and laid out as 5 tightly packed floats
+ * so the array can be uploaded to a vertex buffer as is.
+ */
+struct Star {
+    float x, y;
+    float r, g, b;
+};
+
+std::vector<Star> generateStarfield(int count = 4000, unsigned seed = 12345);
+
+#endif // STARFIELD_HPP
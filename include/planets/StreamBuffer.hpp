@@ -0,0 +1,55 @@
+#ifndef STREAM_BUFFER_HPP
+#define STREAM_BUFFER_HPP
+
+#include <glad/glad.h>
+#include <cstddef>
+
+/**
+ * @brief Triple-buffered GPU ring for per-frame vertex streams.
+ *
+ * The buffer is split into REGIONS equal regions. Each frame writes into the next
+ * region after waiting on the fence left by the last draw that read it, so the CPU
+ * never overwrites data the GPU is still consuming and never forces a reallocation.
+ * With ARB_buffer_storage the whole buffer is mapped once (persistent + coherent);
+ * otherwise each region is mapped unsynchronized for the duration of the write.
+ */
+class StreamBuffer {
+public:
+    static constexpr int REGIONS = 3;
+
+    StreamBuffer() = default;
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // (Re)creates the buffer with the given per-region size in bytes
+    bool create(GLenum target, std::size_t regionBytes);
+    void destroy();
+
+    // Advances to the next region and returns a write pointer to its start,
+    // or nullptr if the request does not fit a region.
+    void* beginWrite(std::size_t bytes);
+    void endWrite();
+
+    // Marks the current region as in use by the commands issued so far
+    void fence();
+
+    GLuint id() const { return buffer; }
+    std::size_t regionSize() const { return regionBytes; }
+    std::size_t byteSize() const { return regionBytes * REGIONS; }
+    std::size_t currentOffset() const { return static_cast<std::size_t>(region) * regionBytes; }
+    bool isPersistent() const { return persistent; }
+
+private:
+    GLuint buffer = 0;
+    GLenum target = GL_ARRAY_BUFFER;
+    std::size_t regionBytes = 0;
+    int region = REGIONS - 1; // first beginWrite lands on region 0
+    GLsync fences[REGIONS] = {};
+    void* mapped = nullptr;   // persistent mapping of the whole buffer
+    bool persistent = false;
+    bool writing = false;
+
+    void waitForRegion(int r);
+};
+
+#endif // STREAM_BUFFER_HPP
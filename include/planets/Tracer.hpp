@@ -0,0 +1,81 @@
+#ifndef TRACER_HPP
+#define TRACER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Opt-in trace-event recorder for loading runs into chrome://tracing or Perfetto.
+ *
+ * Every PLANETS_PROFILE_SCOPE doubles as a trace span while a capture is recording,
+ * on any thread. Each thread appends begin/end events to its own fixed ring (single
+ * producer, lock-free; the buffer is allocated on the thread's first event), and a
+ * full ring drops events rather than blocking. A capture skips a number of frames,
+ * records a window of frames and then writes Chrome Trace Event JSON; finish() writes
+ * a capture that is still recording, e.g. at exit.
+ */
+class Tracer {
+public:
+    static constexpr std::size_t RING_EVENTS = std::size_t(1) << 16; // per thread, power of two
+
+    static Tracer& get();
+    // Cheap check for instrumentation: true while a capture window is recording
+    static bool recording() { return recordingFlag.load(std::memory_order_relaxed); }
+
+    // Records `frames` frames after skipping `skip`, then writes path
+    void capture(const std::string& path, int frames, int skip = 0);
+    bool isCapturing() const { return armed; }
+    void finish();
+
+    // Frame brackets from the main loop; also drive the capture window
+    void beginFrame();
+    void endFrame();
+
+    // Names the calling thread in the trace
+    void setThreadName(const std::string& name);
+    // Bytes held by the per-thread rings allocated so far
+    std::size_t memoryBytes();
+
+    using Clock = std::chrono::steady_clock;
+    void begin(const char* name, Clock::time_point t) { record(name, t, 'B'); }
+    void end(const char* name, Clock::time_point t) { record(name, t, 'E'); }
+
+private:
+    struct Event {
+        const char* name;
+        std::int64_t ns;
+        char phase;
+    };
+    struct ThreadRing {
+        Event events[RING_EVENTS];
+        std::atomic<std::uint64_t> head{0};  // written by the owning thread only
+        std::atomic<std::uint64_t> start{0}; // first event of the capture, set by the consumer
+        std::atomic<std::uint64_t> dropped{0};
+        std::string name;
+        int tid = 0;
+    };
+
+    Tracer() = default;
+    ThreadRing* ring();
+    void record(const char* name, Clock::time_point t, char phase);
+    bool write();
+
+    static std::atomic<bool> recordingFlag;
+
+    std::mutex ringsMutex; // guards registration and the ring list
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    Clock::time_point epoch = Clock::now();
+
+    // Capture window, main thread only
+    std::string path;
+    bool armed = false;
+    bool frameOpen = false;
+    int skipFrames = 0, framesLeft = 0;
+};
+
+#endif // TRACER_HPP
@@ -0,0 +1,86 @@
+#ifndef TRAIL_RECORDER_HPP
+#define TRAIL_RECORDER_HPP
+
+#include <vector>
+#include <cstddef>
+#include "Planet.hpp"
+#include "Vector2.hpp"
+
+/**
+ * @brief Samples planet positions into per-body trails at a fixed sim-time cadence.
+ *
+ * Each trail is a bounded ring of committed points plus a short run of pending
+ * samples. A pending run is only collapsed into a committed point once the chord
+ * from the last committed point can no longer represent it within the error
+ * tolerance (streaming Douglas-Peucker), so straight stretches cost a handful of
+ * points while tight curves keep their detail.
+ */
+class TrailRecorder {
+public:
+    struct TrailPoint {
+        Vector2 p;
+        double t = 0.0; // sim time the point was sampled at; a float runs out of resolution on long runs
+    };
+
+    struct Trail {
+        std::vector<TrailPoint> ring;    // committed points, grows up to capacity then wraps
+        std::size_t head = 0;            // index of the oldest committed point once wrapped
+        std::vector<TrailPoint> pending; // samples since the last committed point
+        float minX = 0.0f, minY = 0.0f, maxX = 0.0f, maxY = 0.0f; // bounds of committed + pending points
+
+        std::size_t committedCount() const { return ring.size(); }
+        const TrailPoint& committed(std::size_t i) const { return ring[(head + i) % ring.size()]; }
+        // Drawable point count: committed points plus the newest pending sample
+        std::size_t size() const { return ring.size() + (pending.empty() ? 0 : 1); }
+        const TrailPoint& at(std::size_t i) const { return i < ring.size() ? committed(i) : pending.back(); }
+    };
+
+    TrailRecorder() = default;
+
+    // Enabling reserves every trail at full capacity; disabled recorders hold no points
+    void setEnabled(bool e);
+    bool isEnabled() const { return enabled; }
+
+    void setSampleInterval(double simSeconds) { sampleInterval = simSeconds > 0.0 ? simSeconds : 0.0; }
+    double getSampleInterval() const { return sampleInterval; }
+
+    // Maximum perpendicular deviation (world units) a dropped sample may have from its chord
+    void setTolerance(float worldUnits) { tolerance = worldUnits > 0.0f ? worldUnits : 0.0f; }
+    float getTolerance() const { return tolerance; }
+
+    void setCapacity(std::size_t points);
+    std::size_t getCapacity() const { return capacity; }
+
+    // Resize to one empty trail per body
+    void reset(std::size_t bodyCount);
+    void clear();
+
+    // Called after every physics step; samples only when the cadence has elapsed
+    void record(const std::vector<Planet>& planets, double simTime) {
+        if (!enabled) return;
+        if (hasSampled && simTime - lastSampleTime < sampleInterval) return;
+        sample(planets, simTime);
+    }
+
+    std::size_t size() const { return trails.size(); }
+    const Trail& getTrail(std::size_t i) const { return trails[i]; }
+    // Bytes reserved by all trails (walks every trail)
+    std::size_t memoryBytes() const;
+
+private:
+    std::vector<Trail> trails;
+    bool enabled = true;
+    bool hasSampled = false;
+    double lastSampleTime = 0.0;
+    double sampleInterval = 0.005;
+    float tolerance = 0.001f;
+    std::size_t capacity = 1000;
+    static constexpr std::size_t maxPending = 64; // bounds the per-sample check cost
+
+    void sample(const std::vector<Planet>& planets, double simTime);
+    void push(Trail& trail, const TrailPoint& pt);
+    void commit(Trail& trail, const TrailPoint& pt);
+    bool chordFits(const Trail& trail, const TrailPoint& end) const;
+};
+
+#endif // TRAIL_RECORDER_HPP
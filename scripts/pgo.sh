@@ -0,0 +1,51 @@
+#!/usr/bin/env bash
+# Profile-guided build: instrumented build, training on the benchmark scenarios,
+# then an optimised rebuild with the collected profiles.
+#
+#   scripts/pgo.sh [BUILD_DIR] [extra cmake args...]
+#
+# BUILD_DIR defaults to build-pgo. Both phases use the same build directory, because
+# GCC keys profile files by object path. Extra arguments go to both configure steps,
+# e.g. -DPLANETS_ARCH=native -DPLANETS_BUILD_GUI=OFF. Set PGO_SCENARIOS to train on a
+# different scenario file.
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD="${1:-build-pgo}"
+[ $# -gt 0 ] && shift
+mkdir -p "$BUILD"
+BUILD="$(cd "$BUILD" && pwd)"
+PROFILES="$BUILD/pgo-profiles"
+SCENARIOS="${PGO_SCENARIOS:-$ROOT/scenarios/benchmark.cfg}"
+JOBS="$(nproc 2>/dev/null || echo 4)"
+
+configure() {
+    cmake -S "$ROOT" -B "$BUILD" -DCMAKE_BUILD_TYPE=Release -DPLANETS_LTO=ON \
+        -DPLANETS_PGO="$1" -DPLANETS_PGO_DIR="$PROFILES" "${@:2}"
+}
+
+echo "== Instrumented build"
+rm -rf "$PROFILES"
+mkdir -p "$PROFILES"
+configure GENERATE "$@"
+cmake --build "$BUILD" -j"$JOBS"
+
+echo "== Training on $SCENARIOS"
+TRAIN="$(mktemp -d)"
+trap 'rm -rf "$TRAIN"' EXIT
+(cd "$TRAIN" && "$BUILD/planets_batch" "$SCENARIOS") 2>&1 | sed 's/^/   /'
+# The CPU rasterizer is hot in --software runs; the GUI target may not be built
+if [ -x "$BUILD/PlanetsProject" ]; then
+    (cd "$TRAIN" && "$BUILD/PlanetsProject" --software --frames 120 --bodies 500 \
+        --capture "$TRAIN/train.rgba" >/dev/null) || echo "   (software render training skipped)"
+fi
+
+# Clang writes raw profiles that need merging; GCC's .gcda files are used as they are
+if compgen -G "$PROFILES/*.profraw" >/dev/null; then
+    llvm-profdata merge -output="$PROFILES/merged.profdata" "$PROFILES"/*.profraw
+fi
+
+echo "== Optimised build"
+configure USE "$@"
+cmake --build "$BUILD" -j"$JOBS"
+echo "PGO build ready in $BUILD (profiles in $PROFILES)"
@@ -0,0 +1,485 @@
+// planets_batch: runs simulation scenarios from a config file at full speed, with no
+// window, GL context or render loop. Each scenario prints its throughput and the drift
+// of the conserved quantities, and can log diagnostics and the final state as CSV and
+// render frames on the CPU rasterizer.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "planets/Simulation.hpp"
+#include "planets/Camera.hpp"
+#include "planets/Diagnostics.hpp"
+#include "planets/ImageWriter.hpp"
+#include "planets/Kernels.hpp"
+#include "planets/MemoryTracker.hpp"
+#include "planets/MetricsServer.hpp"
+#include "planets/PerfCounters.hpp"
+#include "planets/SoftwareRenderer.hpp"
+#include "planets/Tracer.hpp"
+
+using namespace std;
+
+// One [section] of the scenario file; keys above the first section set the defaults
+struct Scenario {
+    string name = "default";
+    string init = "random"; // random | binary
+    int bodies = 1000;
+    unsigned seed = 1337;
+    float dt = 0.0015f;
+    float gravity = 0.05f;
+    float softening = 0.02f;
+    long long steps = 1000;
+    bool trails = false;
+    int diagnosticsEvery = 0; // steps between diagnostics rows, 0 = final state only
+    float theta = 0.5f;
+    string diagnosticsCsv;
+    string output; // final body state as CSV
+    string render; // frames from SoftwareRenderer (.y4m, .png sequence or raw RGBA)
+    int renderEvery = 0; // steps between frames, 0 = final state only
+    int renderWidth = 1280, renderHeight = 720;
+    int allocationWarmup = -1;
+};
+
+struct Options {
+    string configPath;
+    string only;
+    string metricsSocket;
+    bool perfCounters = false;
+    string isa;
+    bool checkKernels = false;
+    string render; // overrides the render key of the scenario that runs
+};
+
+static const char* USAGE =
+    "Usage: planets_batch SCENARIOS.cfg [--only NAME] [--metrics-socket PATH] [--perf-counters] [--isa NAME]\n"
+    "                     [--render out.y4m|out.png|out.rgba]\n"
+    "       planets_batch --check-kernels\n";
+
+static string trim(const string& s) {
+    const size_t b = s.find_first_not_of(" \t\r");
+    if (b == string::npos) return "";
+    return s.substr(b, s.find_last_not_of(" \t\r") - b + 1);
+}
+
+static bool parseNumber(const string& v, double& out) {
+    char* end = nullptr;
+    out = strtod(v.c_str(), &end);
+    return !v.empty() && *end == '\0' && isfinite(out);
+}
+
+// Applies key = value to a scenario; returns an error message or ""
+static string applyKey(Scenario& s, const string& key, const string& value) {
+    double x = 0.0;
+    const bool numeric = parseNumber(value, x);
+    auto needNumber = [&](double lo) -> string {
+        if (!numeric) return "expected a number for " + key;
+        if (x < lo) return key + " must be at least " + to_string(lo);
+        return "";
+    };
+    string err;
+    if (key == "init") {
+        if (value != "random" && value != "binary") return "init must be random or binary";
+        s.init = value;
+    } else if (key == "bodies") {
+        if ((err = needNumber(1)).empty()) s.bodies = static_cast<int>(x);
+    } else if (key == "seed") {
+        if ((err = needNumber(0)).empty()) s.seed = static_cast<unsigned>(x);
+    } else if (key == "dt") {
+        if ((err = needNumber(0)).empty()) s.dt = static_cast<float>(x);
+        if (err.empty() && x <= 0.0) err = "dt must be positive";
+    } else if (key == "gravity") {
+        if ((err = needNumber(0)).empty()) s.gravity = static_cast<float>(x);
+    } else if (key == "softening") {
+        if ((err = needNumber(0)).empty()) s.softening = static_cast<float>(x);
+    } else if (key == "steps") {
+        if ((err = needNumber(1)).empty()) s.steps = static_cast<long long>(x);
+    } else if (key == "time") {
+        // Sim time to cover at the dt given so far
+        if ((err = needNumber(0)).empty()) s.steps = max(1LL, static_cast<long long>(ceil(x / s.dt)));
+    } else if (key == "trails") {
+        if (value != "on" && value != "off") return "trails must be on or off";
+        s.trails = value == "on";
+    } else if (key == "diagnostics_every") {
+        if ((err = needNumber(0)).empty()) s.diagnosticsEvery = static_cast<int>(x);
+    } else if (key == "theta") {
+        if ((err = needNumber(0.05)).empty()) s.theta = static_cast<float>(x);
+    } else if (key == "diagnostics_csv") {
+        s.diagnosticsCsv = value;
+    } else if (key == "output") {
+        s.output = value;
+    } else if (key == "render") {
+        s.render = value;
+    } else if (key == "render_every") {
+        if ((err = needNumber(0)).empty()) s.renderEvery = static_cast<int>(x);
+    } else if (key == "render_size") {
+        int w = 0, h = 0;
+        if (sscanf(value.c_str(), "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0) return "render_size must be WIDTHxHEIGHT";
+        s.renderWidth = w;
+        s.renderHeight = h;
+    } else if (key == "assert_no_alloc") {
+        if ((err = needNumber(0)).empty()) s.allocationWarmup = static_cast<int>(x);
+    } else {
+        return "unknown key " + key;
+    }
+    return err;
+}
+
+static bool loadScenarios(const string& path, vector<Scenario>& out) {
+    ifstream in(path);
+    if (!in) {
+        cerr << "Cannot open " << path << "\n";
+        return false;
+    }
+    Scenario defaults;
+    Scenario* current = &defaults;
+    string raw;
+    for (int lineNo = 1; getline(in, raw); ++lineNo) {
+        const string line = trim(raw.substr(0, raw.find('#')));
+        if (line.empty()) continue;
+        if (line.front() == '[') {
+            if (line.back() != ']' || line.size() < 3) {
+                cerr << path << ":" << lineNo << ": malformed section header\n";
+                return false;
+            }
+            out.push_back(defaults);
+            out.back().name = trim(line.substr(1, line.size() - 2));
+            current = &out.back();
+            continue;
+        }
+        const size_t eq = line.find('=');
+        if (eq == string::npos) {
+            cerr << path << ":" << lineNo << ": expected key = value\n";
+            return false;
+        }
+        const string err = applyKey(*current, trim(line.substr(0, eq)), trim(line.substr(eq + 1)));
+        if (!err.empty()) {
+            cerr << path << ":" << lineNo << ": " << err << "\n";
+            return false;
+        }
+    }
+    // A file without sections is a single scenario
+    if (out.empty()) out.push_back(defaults);
+    return true;
+}
+
+static bool parseOptions(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const string arg = argv[i];
+        auto next = [&](const char* name) -> const char* {
+            if (i + 1 >= argc) {
+                cerr << "Missing value for " << name << "\n";
+                return nullptr;
+            }
+            return argv[++i];
+        };
+        const char* v = nullptr;
+        if (arg == "--only") {
+            if (!(v = next("--only"))) return false;
+            opt.only = v;
+        } else if (arg == "--metrics-socket") {
+            if (!(v = next("--metrics-socket"))) return false;
+            opt.metricsSocket = v;
+        } else if (arg == "--perf-counters") {
+            opt.perfCounters = true;
+        } else if (arg == "--isa") {
+            if (!(v = next("--isa"))) return false;
+            opt.isa = v;
+        } else if (arg == "--render") {
+            if (!(v = next("--render"))) return false;
+            opt.render = v;
+        } else if (arg == "--check-kernels") {
+            opt.checkKernels = true;
+        } else if (!arg.empty() && arg[0] != '-' && opt.configPath.empty()) {
+            opt.configPath = arg;
+        } else {
+            cerr << "Unknown option " << arg << "\n" << USAGE;
+            return false;
+        }
+    }
+    if (opt.configPath.empty() && !opt.checkKernels) {
+        cerr << USAGE;
+        return false;
+    }
+    return true;
+}
+
+// Runs every kernel variant this CPU supports against the scalar reference on the same
+// random system and reports the largest relative deviation
+static bool checkKernels() {
+    constexpr size_t N = 1537; // not a multiple of any vector width, so remainders run too
+    constexpr float TOLERANCE = 1e-4f;
+    mt19937 rng(42);
+    uniform_real_distribution<float> pos(-2.5f, 2.5f), vel(-0.5f, 0.5f), mass(0.5f, 8.0f);
+    vector<float> x(N), y(N), vx(N), vy(N), m(N);
+    for (size_t i = 0; i < N; ++i) {
+        x[i] = pos(rng); y[i] = pos(rng); vx[i] = vel(rng); vy[i] = vel(rng); m[i] = mass(rng);
+    }
+    x[7] = x[3]; y[7] = y[3]; // a coincident pair
+    m[11] = 0.0f;             // and a massless body
+
+    struct Result {
+        vector<float> ax, ay, x, y, vx, vy, packed;
+        double sums[5];
+    };
+    auto run = [&](const kernels::Table& k) {
+        Result r{ vector<float>(N, 0.0f), vector<float>(N, 0.0f), x, y, vx, vy, vector<float>(2 * N), {} };
+        k.forces(x.data(), y.data(), m.data(), r.ax.data(), r.ay.data(), N, 0.05f, 0.02f * 0.02f);
+        k.integrate(r.x.data(), r.y.data(), r.vx.data(), r.vy.data(), r.ax.data(), r.ay.data(), N, 0.0015f);
+        k.sums(r.x.data(), r.y.data(), r.vx.data(), r.vy.data(), m.data(), N, r.sums);
+        k.packPositions(x.data(), y.data(), N, r.packed.data());
+        return r;
+    };
+    // Deviation relative to the largest magnitude in the reference array
+    auto deviation = [](const vector<float>& a, const vector<float>& b) {
+        double scale = 0.0, worst = 0.0;
+        for (size_t i = 0; i < a.size(); ++i) {
+            scale = max(scale, static_cast<double>(fabs(a[i])));
+            worst = max(worst, static_cast<double>(fabs(a[i] - b[i])));
+        }
+        return scale > 0.0 ? worst / scale : worst;
+    };
+
+    const Result reference = run(*kernels::table(kernels::Isa::Scalar));
+    bool ok = true;
+    for (int i = 0; i < static_cast<int>(kernels::Isa::COUNT); ++i) {
+        const kernels::Isa isa = static_cast<kernels::Isa>(i);
+        const kernels::Table* t = kernels::table(isa);
+        if (!t) {
+            cout << kernels::isaName(isa) << ": not available\n";
+            continue;
+        }
+        const Result r = run(*t);
+        double worst = 0.0;
+        for (auto pair : { make_pair(&reference.ax, &r.ax), make_pair(&reference.ay, &r.ay),
+                           make_pair(&reference.x, &r.x), make_pair(&reference.y, &r.y),
+                           make_pair(&reference.vx, &r.vx), make_pair(&reference.vy, &r.vy),
+                           make_pair(&reference.packed, &r.packed) }) {
+            worst = max(worst, deviation(*pair.first, *pair.second));
+        }
+        for (int s = 0; s < 5; ++s) {
+            const double scale = max(fabs(reference.sums[s]), 1.0);
+            worst = max(worst, fabs(reference.sums[s] - r.sums[s]) / scale);
+        }
+        const bool pass = worst <= TOLERANCE;
+        ok = ok && pass;
+        char line[96];
+        snprintf(line, sizeof(line), "%s: max relative deviation %.2e %s\n", kernels::isaName(isa), worst,
+                 pass ? "ok" : "MISMATCH");
+        cout << line;
+    }
+    return ok;
+}
+
+static double wallSeconds() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void writeDiagnosticsRow(FILE* f, std::uint64_t step, const Diagnostics::Sample& s) {
+    fprintf(f, "%llu,%.9g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.9g,%.6e,%.6e,%.6e\n",
+            static_cast<unsigned long long>(step), s.simTime, s.kinetic, s.potential, s.energy, s.momentumX,
+            s.momentumY, s.angularMomentum, s.virialRatio, s.energyDrift, s.momentumDrift, s.angularDrift);
+}
+
+static bool writeState(const Simulation& sim, const string& path) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        cerr << "Cannot open " << path << "\n";
+        return false;
+    }
+    fprintf(f, "id,mass,radius,x,y,vx,vy\n");
+    const vector<Planet>& planets = sim.getPlanets();
+    for (size_t i = 0; i < planets.size(); ++i) {
+        const Planet& p = planets[i];
+        fprintf(f, "%zu,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g\n", i, p.getMass(), p.getRadius(), p.getP().getX(),
+                p.getP().getY(), p.getV().getX(), p.getV().getY());
+    }
+    const bool ok = fclose(f) == 0;
+    if (!ok) cerr << "Failed writing " << path << "\n";
+    return ok;
+}
+
+// Frame rate recorded in .y4m headers; one frame per render_every steps either way
+static constexpr int RENDER_FPS = 30;
+
+static bool runScenario(const Scenario& sc, MetricsServer& metrics) {
+    Simulation sim;
+    sim.setGravityParams(sc.gravity, sc.softening);
+    sim.setTimeStep(sc.dt);
+    sim.getTrails().setEnabled(sc.trails);
+    if (sc.init == "binary") sim.init();
+    else sim.initRandom(sc.bodies, sc.seed);
+    sim.setAllocationCheck(sc.allocationWarmup);
+
+    // Frames are rasterized on the CPU; the camera frames the system as in the GUI
+    ImageSequenceWriter writer;
+    unique_ptr<SoftwareRenderer> renderer;
+    Camera camera(static_cast<float>(sc.renderWidth), static_cast<float>(sc.renderHeight));
+    if (!sc.render.empty()) {
+        if (!writer.open(sc.render, ImageSequenceWriter::formatFromPath(sc.render), sc.renderWidth, sc.renderHeight,
+                         RENDER_FPS)) {
+            return false;
+        }
+        renderer = make_unique<SoftwareRenderer>(sc.renderWidth, sc.renderHeight);
+    }
+    const float frameDt = sc.dt * max(sc.renderEvery, 1);
+    auto renderFrame = [&] {
+        camera.update(sim, frameDt);
+        renderer->render(sim, camera);
+        writer.writeFrame(renderer->getPixels().data(), static_cast<size_t>(sc.renderWidth) * 4, true);
+    };
+
+    Diagnostics diagnostics;
+    diagnostics.setTheta(sc.theta);
+    FILE* csv = nullptr;
+    if (!sc.diagnosticsCsv.empty()) {
+        csv = fopen(sc.diagnosticsCsv.c_str(), "w");
+        if (!csv) {
+            cerr << "Cannot open " << sc.diagnosticsCsv << "\n";
+            return false;
+        }
+        fprintf(csv, "step,sim_time,kinetic,potential,energy,momentum_x,momentum_y,angular_momentum,"
+                     "virial_ratio,energy_drift,momentum_drift,angular_drift\n");
+    }
+    // The reference sample for the drifts is the initial state
+    diagnostics.flush(sim);
+    if (csv) writeDiagnosticsRow(csv, 0, diagnostics.getLatest());
+    if (renderer && sc.renderEvery > 0) renderFrame();
+
+    cout << "[" << sc.name << "] " << sim.getPlanets().size() << " bodies, " << sc.steps << " steps of dt "
+         << sc.dt << "\n";
+    const bool publishing = metrics.isRunning();
+    constexpr int PUBLISH_STRIDE = 16; // steps between metrics/diagnostics polls
+    double stepping = 0.0;
+    double mark = wallSeconds();
+    for (long long i = 1; i <= sc.steps; ++i) {
+        sim.step();
+        const bool row = sc.diagnosticsEvery > 0 && i % sc.diagnosticsEvery == 0 && i != sc.steps;
+        const bool frame = renderer && sc.renderEvery > 0 && i % sc.renderEvery == 0 && i != sc.steps;
+        if (row || frame) {
+            // Blocking, so each row or frame shows exactly this step; not counted as stepping time
+            const double now = wallSeconds();
+            stepping += now - mark;
+            if (row) {
+                diagnostics.flush(sim);
+                if (csv) writeDiagnosticsRow(csv, sim.getStepCount(), diagnostics.getLatest());
+            }
+            if (frame) renderFrame();
+            mark = wallSeconds();
+        } else if (publishing && i % PUBLISH_STRIDE == 0) {
+            const double now = wallSeconds();
+            diagnostics.update(sim, now);
+            if (metrics.publish(sim, now) && diagnostics.hasSample()) {
+                metrics.publishDiagnostics(diagnostics.getLatest());
+            }
+        }
+    }
+    stepping += wallSeconds() - mark;
+    if (renderer) renderFrame();
+
+    diagnostics.flush(sim);
+    const Diagnostics::Sample& s = diagnostics.getLatest();
+    if (csv) {
+        writeDiagnosticsRow(csv, sim.getStepCount(), s);
+        if (fclose(csv) != 0) cerr << "Failed writing " << sc.diagnosticsCsv << "\n";
+    }
+    if (publishing) metrics.publishDiagnostics(s);
+
+    const double n = static_cast<double>(sim.getPlanets().size());
+    const double stepsPerSecond = stepping > 0.0 ? sc.steps / stepping : 0.0;
+    char line[256];
+    snprintf(line, sizeof(line), "  %.3f s wall, %.1f steps/s, %.3g pair interactions/s, sim time %.4g\n", stepping,
+             stepsPerSecond, stepsPerSecond * n * (n - 1.0) / 2.0, sim.getSimTime());
+    cout << line;
+    snprintf(line, sizeof(line), "  drift: energy %.3e, momentum %.3e, angular momentum %.3e; virial 2K/|U| %.4f\n",
+             s.energyDrift, s.momentumDrift, s.angularDrift, s.virialRatio);
+    cout << line;
+
+    bool ok = true;
+    if (!sc.output.empty()) {
+        ok = writeState(sim, sc.output);
+        if (ok) cout << "  wrote final state to " << sc.output << "\n";
+    }
+    if (sc.diagnosticsEvery > 0 && csv) cout << "  wrote diagnostics to " << sc.diagnosticsCsv << "\n";
+    if (renderer) {
+        cout << "  rendered " << writer.getFramesWritten() << " frames to " << sc.render << "\n";
+        writer.close();
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        return 1;
+    }
+    if (opt.checkKernels) {
+        return checkKernels() ? 0 : 2;
+    }
+    if (!opt.isa.empty()) {
+        kernels::Isa isa;
+        if (!kernels::parseIsa(opt.isa.c_str(), isa)) {
+            cerr << "Unknown ISA " << opt.isa << " (scalar, sse4, avx2, avx512)\n";
+            return 1;
+        }
+        if (!kernels::select(isa)) {
+            cerr << kernels::isaName(isa) << " kernels are not available on this machine\n";
+            return 1;
+        }
+    }
+    vector<Scenario> scenarios;
+    if (!loadScenarios(opt.configPath, scenarios)) {
+        return 1;
+    }
+    if (!opt.render.empty()) {
+        // One output path, so it must name a single scenario
+        const long long selected = count_if(scenarios.begin(), scenarios.end(), [&](const Scenario& sc) {
+            return opt.only.empty() || sc.name == opt.only;
+        });
+        if (selected > 1) {
+            cerr << "--render needs --only when " << opt.configPath << " has several scenarios\n";
+            return 1;
+        }
+        for (Scenario& sc : scenarios) sc.render = opt.render;
+    }
+    Tracer::get().setThreadName("Main");
+    if (opt.perfCounters && !PerfCounters::get().setEnabled(true)) {
+        cerr << "Hardware counters unavailable: " << PerfCounters::get().getError() << "\n";
+    }
+    if (!MemoryTracker::isTracking()) {
+        for (const Scenario& sc : scenarios) {
+            if (sc.allocationWarmup >= 0) {
+                cerr << "assert_no_alloc needs a build with -DPLANETS_ALLOCATION_TRACKING=ON; ignoring\n";
+                break;
+            }
+        }
+    }
+    cout << "Kernels: " << kernels::isaName(kernels::active().isa) << "\n";
+    MetricsServer metrics;
+    if (!opt.metricsSocket.empty()) {
+        if (metrics.start(opt.metricsSocket)) cout << "Serving metrics on unix:" << opt.metricsSocket << "\n";
+        else cerr << "Metrics endpoint unavailable: " << metrics.getError() << "\n";
+    }
+
+    int ran = 0, failed = 0;
+    for (const Scenario& sc : scenarios) {
+        if (!opt.only.empty() && sc.name != opt.only) continue;
+        ++ran;
+        if (!runScenario(sc, metrics)) ++failed;
+        if (PerfCounters::get().isEnabled()) {
+            const PerfCounters& pc = PerfCounters::get();
+            cout << pc.summary(PerfCounters::Forces) << "\n" << pc.summary(PerfCounters::Integrate) << "\n";
+        }
+    }
+    if (ran == 0) {
+        cerr << "No scenario named " << opt.only << " in " << opt.configPath << "\n";
+        return 1;
+    }
+    return failed > 0 ? 2 : 0;
+}
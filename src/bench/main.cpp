@@ -0,0 +1,447 @@
+// planets_bench: microbenchmarks of the physics and rendering hot paths over a range of
+// body counts. Each result is reported per pair interaction or per body, written as
+// JSON, and can be compared against a saved baseline to flag regressions. With
+// --perf-counters the measured calls are also counted with the hardware counters.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "planets/Camera.hpp"
+#include "planets/Kernels.hpp"
+#include "planets/PerfCounters.hpp"
+#include "planets/PhysicsEngine.hpp"
+#include "planets/Simulation.hpp"
+#include "planets/TrailRecorder.hpp"
+
+using namespace std;
+
+struct Options {
+    vector<size_t> sizes = { 10, 100, 1000, 10000, 100000, 1000000 };
+    vector<string> only;
+    double minTime = 0.25;  // seconds of measurement per result
+    int rounds = 5;         // the median round is reported
+    double maxPairs = 1e9;  // O(N^2) benchmarks skip sizes whose single call exceeds this
+    string jsonPath;
+    string baselinePath;
+    double tolerance = 0.10; // slowdown against the baseline that counts as a regression
+    string isa;
+    bool perfCounters = false;
+};
+
+static const char* USAGE =
+    "Usage: planets_bench [--sizes N,N,...] [--only NAME,...] [--min-time SEC] [--rounds N]\n"
+    "                     [--max-pairs P] [--json out.json] [--baseline base.json [--tolerance F]]\n"
+    "                     [--isa scalar|sse4|avx2|avx512] [--perf-counters]\n"
+    "Benchmarks: forces, integrate, step, camera, trails, pack\n";
+
+static vector<string> splitList(const string& s) {
+    vector<string> out;
+    stringstream in(s);
+    string item;
+    while (getline(in, item, ',')) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+static bool parseOptions(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const string arg = argv[i];
+        auto next = [&](const char* name) -> const char* {
+            if (i + 1 >= argc) {
+                cerr << name << " needs a value\n" << USAGE;
+                return nullptr;
+            }
+            return argv[++i];
+        };
+        const char* v = nullptr;
+        if (arg == "--sizes") {
+            if (!(v = next("--sizes"))) return false;
+            opt.sizes.clear();
+            for (const string& n : splitList(v)) {
+                const double x = atof(n.c_str()); // accepts 1e6
+                if (x < 2.0) {
+                    cerr << "Sizes must be at least 2\n";
+                    return false;
+                }
+                opt.sizes.push_back(static_cast<size_t>(x));
+            }
+        } else if (arg == "--only") {
+            if (!(v = next("--only"))) return false;
+            opt.only = splitList(v);
+        } else if (arg == "--min-time") {
+            if (!(v = next("--min-time"))) return false;
+            opt.minTime = max(0.001, atof(v));
+        } else if (arg == "--rounds") {
+            if (!(v = next("--rounds"))) return false;
+            opt.rounds = max(1, atoi(v));
+        } else if (arg == "--max-pairs") {
+            if (!(v = next("--max-pairs"))) return false;
+            opt.maxPairs = atof(v);
+        } else if (arg == "--json") {
+            if (!(v = next("--json"))) return false;
+            opt.jsonPath = v;
+        } else if (arg == "--baseline") {
+            if (!(v = next("--baseline"))) return false;
+            opt.baselinePath = v;
+        } else if (arg == "--tolerance") {
+            if (!(v = next("--tolerance"))) return false;
+            opt.tolerance = max(0.0, atof(v));
+        } else if (arg == "--isa") {
+            if (!(v = next("--isa"))) return false;
+            opt.isa = v;
+        } else if (arg == "--perf-counters") {
+            opt.perfCounters = true;
+        } else {
+            cerr << "Unknown option " << arg << "\n" << USAGE;
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Result {
+    string name;
+    size_t n = 0;
+    string unit;           // "pair" or "body"
+    double items = 0.0;    // units of work per call
+    long long calls = 0;   // calls per round
+    double nsPerCall = 0.0;
+    double nsPerItem = 0.0;
+    double gflops = -1.0;  // < 0 when the benchmark has no meaningful FLOP count
+    // Hardware counters over the measured rounds; < 0 when not collected
+    double ipc = -1.0;
+    double cyclesPerItem = -1.0;
+    double l1dPerItem = -1.0;
+    double llcPerItem = -1.0;
+};
+
+static double nowNanos() {
+    return static_cast<double>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Times `call`, which returns the nanoseconds it wants counted (so it can leave per-call
+// setup out), in rounds of enough calls to fill minTime / rounds. Reports the median round.
+static Result measure(const Options& opt, const function<double()>& call, double items, double flopsPerItem) {
+    call(); // warm caches and grow any buffers
+    const double roundNanos = opt.minTime * 1e9 / opt.rounds;
+    // Grow the call count until one round of them fills the round time
+    long long calls = 1;
+    for (;;) {
+        double t = 0.0;
+        for (long long c = 0; c < calls; ++c) t += call();
+        if (t >= roundNanos || calls >= (1LL << 30)) break;
+        const double estimate = roundNanos / max(t / calls, 1.0);
+        calls = max(calls * 2, static_cast<long long>(estimate * 1.1));
+    }
+    PerfCounters& pc = PerfCounters::get();
+    pc.reset(); // leave the warm-up and calibration calls out of the counts
+    vector<double> perCall;
+    for (int r = 0; r < opt.rounds; ++r) {
+        double t = 0.0;
+        for (long long c = 0; c < calls; ++c) t += call();
+        perCall.push_back(t / calls);
+    }
+    sort(perCall.begin(), perCall.end());
+    Result res;
+    res.items = items;
+    res.calls = calls;
+    res.nsPerCall = perCall[perCall.size() / 2];
+    res.nsPerItem = res.nsPerCall / items;
+    if (flopsPerItem > 0.0) res.gflops = items * flopsPerItem / res.nsPerCall;
+    // Counters cover every measured round, not just the median one
+    const PerfCounters::Totals& t = pc.getTotal(PerfCounters::Benchmark);
+    if (pc.isEnabled() && t.calls > 0) {
+        const double counted = static_cast<double>(t.calls) * items;
+        if (pc.isAvailable(PerfCounters::Cycles)) {
+            res.cyclesPerItem = t.values[PerfCounters::Cycles] / counted;
+            if (pc.isAvailable(PerfCounters::Instructions) && t.values[PerfCounters::Cycles] > 0) {
+                res.ipc = static_cast<double>(t.values[PerfCounters::Instructions]) / t.values[PerfCounters::Cycles];
+            }
+        }
+        if (pc.isAvailable(PerfCounters::L1dMisses)) res.l1dPerItem = t.values[PerfCounters::L1dMisses] / counted;
+        if (pc.isAvailable(PerfCounters::CacheMisses)) res.llcPerItem = t.values[PerfCounters::CacheMisses] / counted;
+    }
+    return res;
+}
+
+// Wraps a callable so its whole duration counts. The counter scope opens before the
+// clock starts and closes after it stops, so its reads stay out of the timing.
+template <typename F>
+static function<double()> timed(F f) {
+    return [f]() mutable {
+        PerfCounters::Scope counted(PerfCounters::Benchmark, 1);
+        const double start = nowNanos();
+        f();
+        return nowNanos() - start;
+    };
+}
+
+// Flops per body of integrate(): the update (8) and the system sums (10)
+static constexpr double BODY_FLOPS = 18.0;
+
+static bool selected(const Options& opt, const string& name) {
+    return opt.only.empty() || find(opt.only.begin(), opt.only.end(), name) != opt.only.end();
+}
+
+static vector<Result> runAll(const Options& opt) {
+    vector<Result> results;
+    auto report = [&](Result r, const string& name, size_t n, const char* unit) {
+        r.name = name;
+        r.n = n;
+        r.unit = unit;
+        char line[256];
+        int len = snprintf(line, sizeof(line), "%-10s %8zu  %12.1f ns/call  %9.3f ns/%s", name.c_str(), n,
+                           r.nsPerCall, r.nsPerItem, unit);
+        if (r.gflops >= 0.0) len += snprintf(line + len, sizeof(line) - len, "  %7.2f GFLOP/s", r.gflops);
+        if (r.ipc >= 0.0) len += snprintf(line + len, sizeof(line) - len, "  %5.2f IPC", r.ipc);
+        if (r.cyclesPerItem >= 0.0) {
+            len += snprintf(line + len, sizeof(line) - len, "  %8.2f cyc/%s", r.cyclesPerItem, unit);
+        }
+        if (r.l1dPerItem >= 0.0) len += snprintf(line + len, sizeof(line) - len, "  %.4f L1D/%s", r.l1dPerItem, unit);
+        if (r.llcPerItem >= 0.0) snprintf(line + len, sizeof(line) - len, "  %.5f LLC/%s", r.llcPerItem, unit);
+        cout << line << endl; // large sizes take a while; show progress as it happens
+        results.push_back(r);
+    };
+
+    for (size_t n : opt.sizes) {
+        const double pairs = 0.5 * static_cast<double>(n) * (n - 1);
+        const bool pairsFit = pairs <= opt.maxPairs;
+        for (const char* name : { "forces", "step" }) {
+            if (pairsFit || !selected(opt, name)) continue;
+            char line[128];
+            snprintf(line, sizeof(line), "%-10s %8zu  skipped (%.2g pairs > --max-pairs)", name, n, pairs);
+            cout << line << "\n";
+        }
+
+        // Trails stay off outside the step benchmark; enabled ones reserve their full capacity
+        Simulation sim;
+        sim.getTrails().setEnabled(false);
+        sim.initRandom(static_cast<int>(n), 1337);
+
+        if (selected(opt, "forces") || selected(opt, "integrate")) {
+            // A private engine over a copy of the bodies, so the kernels run in isolation
+            vector<Planet> bodies = sim.getPlanets();
+            PhysicsEngine physics;
+            for (Planet& p : bodies) physics.addBody(&p);
+            physics.updateSums(); // gathers the arrays; accelerations start at zero
+            if (selected(opt, "forces") && pairsFit) {
+                report(measure(opt, timed([&] { physics.computeForces(); }), pairs, PerfCounters::PAIR_FLOPS),
+                       "forces", n, "pair");
+            }
+            if (selected(opt, "integrate")) {
+                report(measure(opt, timed([&] { physics.integrate(1e-6f); }), static_cast<double>(n), BODY_FLOPS),
+                       "integrate", n, "body");
+            }
+        }
+
+        if (selected(opt, "step") && pairsFit) {
+            Simulation stepped;
+            stepped.initRandom(static_cast<int>(n), 1337);
+            report(measure(opt, timed([&] { stepped.step(); }), pairs, PerfCounters::PAIR_FLOPS), "step", n,
+                   "pair");
+        }
+
+        if (selected(opt, "camera")) {
+            Camera camera(1280.0f, 720.0f);
+            report(measure(opt, timed([&] { camera.update(sim, 1.0f / 60.0f); }), static_cast<double>(n), 0.0),
+                   "camera", n, "body");
+        }
+
+        if (selected(opt, "trails")) {
+            // Bodies orbit the origin so the streaming simplifier commits points as it
+            // would on curved paths; the rotation itself is not timed
+            vector<Planet> bodies = sim.getPlanets();
+            TrailRecorder trails;
+            trails.setCapacity(16);
+            trails.setSampleInterval(0.0);
+            trails.reset(bodies.size());
+            const float c = cos(0.02f), s = sin(0.02f);
+            double simTime = 0.0;
+            report(measure(opt,
+                           [&] {
+                               for (Planet& p : bodies) {
+                                   const float x = p.getP().getX(), y = p.getP().getY();
+                                   p.setP(Vector2(c * x - s * y, s * x + c * y));
+                               }
+                               simTime += 0.01;
+                               PerfCounters::Scope counted(PerfCounters::Benchmark, 1);
+                               const double start = nowNanos();
+                               trails.record(bodies, simTime);
+                               return nowNanos() - start;
+                           },
+                           static_cast<double>(n), 0.0),
+                   "trails", n, "body");
+        }
+
+        if (selected(opt, "pack")) {
+            // The renderer's full position upload (Renderer::uploadPlanetPositions)
+            const PhysicsEngine& physics = sim.getPhysics();
+            vector<float> dst(2 * n);
+            report(measure(opt,
+                           timed([&] {
+                               kernels::active().packPositions(physics.getPositionsX(), physics.getPositionsY(), n,
+                                                               dst.data());
+                           }),
+                           static_cast<double>(n), 0.0),
+                   "pack", n, "body");
+        }
+    }
+    return results;
+}
+
+// A number, or null when it was not measured (negative)
+static string jsonNumber(double v, const char* format) {
+    if (v < 0.0) return "null";
+    char buf[32];
+    snprintf(buf, sizeof(buf), format, v);
+    return buf;
+}
+
+static bool writeJson(const string& path, const Options& opt, const vector<Result>& results) {
+    ofstream out(path);
+    if (!out) {
+        cerr << "Cannot write " << path << "\n";
+        return false;
+    }
+    // One result per line; readBaseline() relies on that
+    out << "{\n  \"isa\": \"" << kernels::isaName(kernels::active().isa) << "\",\n"
+        << "  \"min_time\": " << opt.minTime << ",\n  \"rounds\": " << opt.rounds << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        char line[320];
+        snprintf(line, sizeof(line),
+                 "    {\"name\": \"%s\", \"n\": %zu, \"unit\": \"%s\", \"items\": %.0f, \"calls\": %lld, "
+                 "\"ns_per_call\": %.3f, \"ns_per_item\": %.6g, \"gflops\": ",
+                 r.name.c_str(), r.n, r.unit.c_str(), r.items, r.calls, r.nsPerCall, r.nsPerItem);
+        out << line << jsonNumber(r.gflops, "%.4g");
+        if (opt.perfCounters) {
+            out << ", \"ipc\": " << jsonNumber(r.ipc, "%.3f")
+                << ", \"cycles_per_item\": " << jsonNumber(r.cyclesPerItem, "%.4g")
+                << ", \"l1d_misses_per_item\": " << jsonNumber(r.l1dPerItem, "%.4g")
+                << ", \"llc_misses_per_item\": " << jsonNumber(r.llcPerItem, "%.4g");
+        }
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+// Value of "key" in a flat JSON object on one line ("" if absent)
+static string field(const string& line, const string& key) {
+    const string quoted = "\"" + key + "\":";
+    size_t at = line.find(quoted);
+    if (at == string::npos) return "";
+    at = line.find_first_not_of(" ", at + quoted.size());
+    if (at == string::npos) return "";
+    if (line[at] == '"') {
+        const size_t end = line.find('"', at + 1);
+        return end == string::npos ? "" : line.substr(at + 1, end - at - 1);
+    }
+    const size_t end = line.find_first_of(",}", at);
+    return line.substr(at, end == string::npos ? string::npos : end - at);
+}
+
+static string resultKey(const string& name, size_t n) { return name + "/" + to_string(n); }
+
+// Reads the ns_per_item of each result written by writeJson
+static bool readBaseline(const string& path, map<string, double>& out, string& isa) {
+    ifstream in(path);
+    if (!in) {
+        cerr << "Cannot read baseline " << path << "\n";
+        return false;
+    }
+    string line;
+    while (getline(in, line)) {
+        if (isa.empty()) isa = field(line, "isa");
+        const string name = field(line, "name");
+        const string n = field(line, "n");
+        const string ns = field(line, "ns_per_item");
+        if (name.empty() || n.empty() || ns.empty()) continue;
+        out[resultKey(name, strtoull(n.c_str(), nullptr, 10))] = atof(ns.c_str());
+    }
+    if (out.empty()) {
+        cerr << "No results in baseline " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Prints the change of every result found in the baseline; true if none regressed
+static bool compare(const Options& opt, const vector<Result>& results, const map<string, double>& baseline,
+                    const string& baselineIsa) {
+    const char* isa = kernels::isaName(kernels::active().isa);
+    cout << "\nAgainst " << opt.baselinePath << " (tolerance " << opt.tolerance * 100.0 << "%):\n";
+    if (!baselineIsa.empty() && baselineIsa != isa) {
+        cout << "  note: baseline used " << baselineIsa << " kernels, this run " << isa << "\n";
+    }
+    int regressions = 0, compared = 0;
+    for (const Result& r : results) {
+        const auto it = baseline.find(resultKey(r.name, r.n));
+        if (it == baseline.end() || it->second <= 0.0) continue;
+        ++compared;
+        const double change = r.nsPerItem / it->second - 1.0;
+        const bool regressed = change > opt.tolerance;
+        regressions += regressed;
+        char line[160];
+        snprintf(line, sizeof(line), "  %-10s %8zu  %9.3f -> %9.3f ns/%s  %+6.1f%%%s", r.name.c_str(), r.n,
+                 it->second, r.nsPerItem, r.unit.c_str(), change * 100.0, regressed ? "  REGRESSION" : "");
+        cout << line << "\n";
+    }
+    cout << "  " << compared << " compared, " << regressions << " regression(s)\n";
+    return regressions == 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        return 1;
+    }
+    for (const string& name : opt.only) {
+        static const char* known[] = { "forces", "integrate", "step", "camera", "trails", "pack" };
+        if (find_if(begin(known), end(known), [&](const char* k) { return name == k; }) == end(known)) {
+            cerr << "Unknown benchmark " << name << "\n" << USAGE;
+            return 1;
+        }
+    }
+    if (!opt.isa.empty()) {
+        kernels::Isa isa;
+        if (!kernels::parseIsa(opt.isa.c_str(), isa)) {
+            cerr << "Unknown ISA " << opt.isa << " (scalar, sse4, avx2, avx512)\n";
+            return 1;
+        }
+        if (!kernels::select(isa)) {
+            cerr << kernels::isaName(isa) << " kernels are not available on this machine\n";
+            return 1;
+        }
+    }
+    map<string, double> baseline;
+    string baselineIsa;
+    if (!opt.baselinePath.empty() && !readBaseline(opt.baselinePath, baseline, baselineIsa)) {
+        return 1;
+    }
+
+    if (opt.perfCounters && !PerfCounters::get().setEnabled(true)) {
+        cerr << "Hardware counters unavailable: " << PerfCounters::get().getError() << "\n";
+    }
+    cout << "Kernels: " << kernels::isaName(kernels::active().isa) << "\n";
+    const vector<Result> results = runAll(opt);
+
+    if (!opt.jsonPath.empty()) {
+        if (!writeJson(opt.jsonPath, opt, results)) return 1;
+        cout << "Wrote " << opt.jsonPath << "\n";
+    }
+    if (!baseline.empty() && !compare(opt, results, baseline, baselineIsa)) {
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include "planets/BodyInspector.hpp"
+#include "planets/Simulation.hpp"
+#include "planets/MemoryTracker.hpp"
+#include "planets/Parallel.hpp"
+#include "planets/Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+BodyInspector::BodyInspector() {
+    worker = std::thread([this] { workerLoop(); });
+}
+
+BodyInspector::~BodyInspector() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_one();
+    if (worker.joinable()) worker.join();
+}
+
+float BodyInspector::columnValue(Column column, std::uint32_t id, float mass, float x, float y, float vx, float vy) {
+    switch (column) {
+    case Mass:   return mass;
+    case PosX:   return x;
+    case PosY:   return y;
+    case Speed:  return std::sqrt(vx * vx + vy * vy);
+    case Energy: return 0.5f * mass * (vx * vx + vy * vy);
+    default:     return static_cast<float>(id);
+    }
+}
+
+void BodyInspector::setSort(Column column, bool descending) {
+    if (column == settings.column && descending == settings.descending) return;
+    settings.column = column;
+    settings.descending = descending;
+    settingsDirty = true;
+}
+
+void BodyInspector::setFilter(bool enabled, float lo, float hi) {
+    if (enabled == settings.filter && (!enabled || (lo == settings.lo && hi == settings.hi))) return;
+    settings.filter = enabled;
+    settings.lo = lo;
+    settings.hi = hi;
+    settingsDirty = true;
+}
+
+bool BodyInspector::isBusy() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return busy;
+}
+
+std::size_t BodyInspector::memoryBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    // The worker's buffers are only stable while it is idle
+    if (!busy) {
+        idleBytes = capacityBytes(order) + capacityBytes(jobRows) + capacityBytes(keys) +
+                    capacityBytes(perm) + capacityBytes(built);
+    }
+    return idleBytes;
+}
+
+void BodyInspector::update(const Simulation& sim, double now) {
+    MemoryTracker::TagScope tag(MemoryTracker::UI);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (resultReady) {
+            order.swap(built);
+            resultReady = false;
+        }
+        if (busy) return;
+    }
+
+    // While the simulation runs, re-sort at a fixed cadence rather than every frame
+    const std::uint64_t version = sim.getStateVersion();
+    const bool stale = version != requestedVersion && now - lastRequest >= REFRESH_INTERVAL;
+    if (!settingsDirty && !stale) return;
+
+    // Snapshot only the columns the worker needs; the worker is idle, so the job buffer is ours
+    const std::vector<Planet>& planets = sim.getPlanets();
+    jobRows.resize(planets.size());
+    parallel::forRange(planets.size(), 4096, [&](std::size_t begin, std::size_t end, unsigned) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const Planet& p = planets[i];
+            jobRows[i] = { p.getMass(), p.getP().getX(), p.getP().getY(), p.getV().getX(), p.getV().getY() };
+        }
+    });
+    jobSettings = settings;
+    settingsDirty = false;
+    requestedVersion = version;
+    lastRequest = now;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        busy = true;
+        jobPending = true;
+    }
+    cv.notify_one();
+}
+
+void BodyInspector::workerLoop() {
+    Tracer::get().setThreadName("Inspector");
+    MemoryTracker::TagScope tag(MemoryTracker::UI);
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return stopping || jobPending; });
+            if (stopping) return;
+            jobPending = false;
+        }
+        build();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            resultReady = true;
+            busy = false;
+        }
+    }
+}
+
+void BodyInspector::build() {
+    PLANETS_PROFILE_SCOPE("Sort rows");
+    const std::size_t n = jobRows.size();
+    const Column column = jobSettings.column;
+
+    keys.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        const Row& r = jobRows[i];
+        keys[i] = columnValue(column, static_cast<std::uint32_t>(i), r.mass, r.x, r.y, r.vx, r.vy);
+    }
+    // NaN keys would break the strict weak ordering; sort them last
+    for (float& k : keys) {
+        if (std::isnan(k)) k = std::numeric_limits<float>::infinity();
+    }
+
+    // Ids are already in order; other columns repair the previous permutation
+    const bool reuse = perm.size() == n && permColumn == column;
+    if (!reuse || column == Id) {
+        perm.resize(n);
+        std::iota(perm.begin(), perm.end(), 0u);
+    }
+    permColumn = column;
+    if (column != Id) {
+        auto less = [this](std::uint32_t a, std::uint32_t b) {
+            return keys[a] < keys[b] || (keys[a] == keys[b] && a < b);
+        };
+        // Insertion sort with a move budget: linear for the few swaps a short
+        // interval of motion causes, abandoned when the order changed a lot
+        bool sorted = reuse;
+        if (reuse) {
+            std::size_t budget = 8 * n + 1024;
+            for (std::size_t i = 1; i < n && sorted; ++i) {
+                const std::uint32_t v = perm[i];
+                std::size_t j = i;
+                for (; j > 0 && less(v, perm[j - 1]); --j) {
+                    perm[j] = perm[j - 1];
+                    if (--budget == 0) break;
+                }
+                perm[j] = v;
+                if (budget == 0) sorted = false;
+            }
+        }
+        if (!sorted) std::sort(perm.begin(), perm.end(), less);
+    }
+
+    built.clear();
+    built.reserve(n);
+    const bool filter = jobSettings.filter;
+    auto emit = [&](std::uint32_t i) {
+        if (!filter || (keys[i] >= jobSettings.lo && keys[i] <= jobSettings.hi)) built.push_back(i);
+    };
+    if (jobSettings.descending) {
+        for (std::size_t k = n; k-- > 0;) emit(perm[k]);
+    } else {
+        for (std::size_t k = 0; k < n; ++k) emit(perm[k]);
+    }
+}
@@ -1,5 +1,8 @@
 #include "planets/Camera.hpp"
+#include "planets/Simulation.hpp"
+#include "planets/Parallel.hpp"
 #include <algorithm>
+#include <cmath>
 #include <limits>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -8,45 +11,30 @@ Camera::Camera(float screenWidth, float screenHeight)
     : position(0.0f), target(0.0f), zoom(1.0f), smoothing(5.0f),
     aspect(screenWidth / screenHeight) {}
 
-void Camera::update(const std::vector<Planet>& planets, float deltaTime) {
+void Camera::update(const Simulation& sim, float deltaTime) {
+    const std::vector<Planet>& planets = sim.getPlanets();
     if (planets.empty()) return;
 
+    // One framing pass per frame: inlier COM (follow target) and the zoom that fits them
+    const Vector2 com = sim.getCenterOfMass();
+    glm::vec2 inlierCom;
+    float optimalZoom = 1.0f;
+    computeFraming(planets, glm::vec2(com.getX(), com.getY()), inlierCom, optimalZoom);
+
     // Check if we're following a specific planet
     if (followedPlanetIndex >= 0 && followedPlanetIndex < static_cast<int>(planets.size())) {
         // Follow the specific planet
         const Planet& followedPlanet = planets[followedPlanetIndex];
         target = glm::vec2(followedPlanet.getP().getX(), followedPlanet.getP().getY());
     } else {
-        // Follow COM (default behavior)
+        // Follow COM of the inliers (default behavior)
         followedPlanetIndex = -1; // reset if out of bounds
-        
-        // Compute inlier set by excluding far-out bodies
-        std::vector<size_t> inliers;
-        computeInliers(planets, inliers);
-
-        // Recompute COM using inliers for better stability
-        if (!inliers.empty()) {
-            glm::dvec2 weightedSum(0.0);
-            double totalMass = 0.0;
-            for (size_t idx : inliers) {
-                const Planet& pl = planets[idx];
-                const double mass = static_cast<double>(pl.getMass());
-                const glm::dvec2 pos(
-                    static_cast<double>(pl.getP().getX()),
-                    static_cast<double>(pl.getP().getY())
-                );
-                weightedSum += pos * mass;
-                totalMass += mass;
-            }
-            target = (totalMass > 0.0) ? glm::vec2(weightedSum / totalMass) : computeCenterOfMass(planets);
-        } else {
-            target = computeCenterOfMass(planets);
-        }
+        target = inlierCom;
     }
     if (!initialized) {
         // Snap on first frame to avoid flash or overshoot
         position = target;
-        zoom = computeOptimalZoom(planets) * zoomOffset;
+        zoom = optimalZoom * zoomOffset;
         initialized = true;
         return;
     }
@@ -57,7 +45,6 @@ void Camera::update(const std::vector<Planet>& planets, float deltaTime) {
     
     // Auto-adjust zoom to fit all planets within the window (always on)
     // Apply user's zoom offset on top of optimal zoom
-    float optimalZoom = computeOptimalZoom(planets);
     float targetZoom = optimalZoom * zoomOffset;
     const float zoomLerpFactor = 1.0f - std::exp(-smoothing * deltaTime * 0.5f); // Slower zoom adjustment
     zoom += (targetZoom - zoom) * zoomLerpFactor;
@@ -89,123 +76,89 @@ glm::mat4 Camera::getViewMatrix() const {
 }
 
 
-glm::vec2 Camera::computeCenterOfMass(const std::vector<Planet>& planets) const {
-    if (planets.empty()) return glm::vec2(0.0f);
-
-    glm::dvec2 weightedSum(0.0);
-    double totalMass = 0.0;
-
-    for (const auto& planet : planets) {
-        const double mass = static_cast<double>(planet.getMass());
-        if (mass <= 0.0) continue;
+void Camera::computeFraming(const std::vector<Planet>& planets, glm::vec2 systemCom,
+                            glm::vec2& outTarget, float& outZoom) {
+    const size_t n = planets.size();
+    auto distanceTo = [&](const Planet& p) {
+        return glm::length(glm::vec2(p.getP().getX(), p.getP().getY()) - systemCom);
+    };
 
-        const glm::dvec2 pos(
-            static_cast<double>(planet.getP().getX()),
-            static_cast<double>(planet.getP().getY())
-        );
+    // Median distance to the system COM: exact for small systems, otherwise from a
+    // fixed strided sample (deterministic, so the framing does not jitter)
+    const size_t sampleCount = std::min(n, MEDIAN_SAMPLE);
+    distanceSample.resize(sampleCount);
+    for (size_t i = 0; i < sampleCount; ++i) {
+        distanceSample[i] = distanceTo(planets[i * n / sampleCount]);
+    }
+    const size_t mid = sampleCount / 2;
+    std::nth_element(distanceSample.begin(), distanceSample.begin() + mid, distanceSample.end());
+    float median = distanceSample[mid];
+    if (median <= 0.0f) median = 1e-4f;
+    const float threshold = outlierMultiplier * median;
 
-        weightedSum += pos * mass;
-        totalMass += mass;
+    // Inlier mass sums and bounds, plus all-body bounds, in one parallel pass
+    constexpr float inf = std::numeric_limits<float>::max();
+    partials.resize(parallel::maxChunks());
+    for (FramePartial& part : partials) {
+        part = FramePartial{ 0.0, 0.0, 0.0, inf, inf, -inf, -inf, inf, inf, -inf, -inf, 0 };
+    }
+    parallel::forRange(n, 4096, [&](size_t begin, size_t end, unsigned chunk) {
+        FramePartial part = partials[chunk];
+        for (size_t i = begin; i < end; ++i) {
+            const Planet& p = planets[i];
+            const float x = p.getP().getX(), y = p.getP().getY(), r = p.getRadius();
+            part.allMinX = std::min(part.allMinX, x - r);
+            part.allMaxX = std::max(part.allMaxX, x + r);
+            part.allMinY = std::min(part.allMinY, y - r);
+            part.allMaxY = std::max(part.allMaxY, y + r);
+            if (distanceTo(p) > threshold) continue;
+            const double m = p.getMass();
+            part.massX += m * x;
+            part.massY += m * y;
+            part.mass += m;
+            part.minX = std::min(part.minX, x - r);
+            part.maxX = std::max(part.maxX, x + r);
+            part.minY = std::min(part.minY, y - r);
+            part.maxY = std::max(part.maxY, y + r);
+            ++part.inliers;
+        }
+        partials[chunk] = part;
+    });
+
+    FramePartial total = partials[0];
+    for (size_t c = 1; c < partials.size(); ++c) {
+        const FramePartial& part = partials[c];
+        total.massX += part.massX;
+        total.massY += part.massY;
+        total.mass += part.mass;
+        total.minX = std::min(total.minX, part.minX);
+        total.maxX = std::max(total.maxX, part.maxX);
+        total.minY = std::min(total.minY, part.minY);
+        total.maxY = std::max(total.maxY, part.maxY);
+        total.allMinX = std::min(total.allMinX, part.allMinX);
+        total.allMaxX = std::max(total.allMaxX, part.allMaxX);
+        total.allMinY = std::min(total.allMinY, part.allMinY);
+        total.allMaxY = std::max(total.allMaxY, part.allMaxY);
+        total.inliers += part.inliers;
     }
 
-    if (totalMass == 0.0) return glm::vec2(0.0f);
+    outTarget = total.mass > 0.0 ? glm::vec2(static_cast<float>(total.massX / total.mass),
+                                             static_cast<float>(total.massY / total.mass))
+                                 : systemCom;
 
-    const glm::dvec2 com = weightedSum / totalMass;
-    return glm::vec2(com);
-}
+    const bool useAll = total.inliers == 0;
+    // Calculate the size of the bounding box, with 20% padding
+    float width = (useAll ? total.allMaxX - total.allMinX : total.maxX - total.minX) * 1.2f;
+    float height = (useAll ? total.allMaxY - total.allMinY : total.maxY - total.minY) * 1.2f;
 
-float Camera::computeOptimalZoom(const std::vector<Planet>& planets) const {
-    if (planets.empty()) return 1.0f;
-    // Build inlier set and compute AABB over inliers
-    std::vector<size_t> inliers;
-    computeInliers(planets, inliers);
-    const bool useAll = inliers.empty();
-
-    float minX = std::numeric_limits<float>::max();
-    float maxX = std::numeric_limits<float>::lowest();
-    float minY = std::numeric_limits<float>::max();
-    float maxY = std::numeric_limits<float>::lowest();
-    
-    if (useAll) {
-        for (const auto& planet : planets) {
-            float x = planet.getP().getX();
-            float y = planet.getP().getY();
-            float radius = planet.getRadius();
-            minX = std::min(minX, x - radius);
-            maxX = std::max(maxX, x + radius);
-            minY = std::min(minY, y - radius);
-            maxY = std::max(maxY, y + radius);
-        }
-    } else {
-        for (size_t idx : inliers) {
-            const auto& planet = planets[idx];
-            float x = planet.getP().getX();
-            float y = planet.getP().getY();
-            float radius = planet.getRadius();
-            minX = std::min(minX, x - radius);
-            maxX = std::max(maxX, x + radius);
-            minY = std::min(minY, y - radius);
-            maxY = std::max(maxY, y + radius);
-        }
-    }
-    
-    // Calculate the size of the bounding box
-    float width = maxX - minX;
-    float height = maxY - minY;
-    
-    // Add 20% padding
-    width *= 1.2f;
-    height *= 1.2f;
-    
     // Guard against degenerate sizes to avoid INF zoom
     width = std::max(width, 1e-4f);
     height = std::max(height, 1e-4f);
 
-    // Calculate zoom needed to fit the bounding box in the window
-    // The window coordinates go from -1 to 1, so total size is 2
-    float zoomX = 2.0f / width;
-    float zoomY = 2.0f / height;
-    
-    // Use the smaller zoom to ensure everything fits
-    float optimalZoom = std::min(zoomX, zoomY);
-    
-    // Clamp to reasonable bounds
-    return std::clamp(optimalZoom, 0.0005f, 100.0f);
-}
-
-void Camera::computeInliers(const std::vector<Planet>& planets, std::vector<size_t>& indices) const {
-    indices.clear();
-    if (planets.empty()) return;
-
-    // Preliminary COM using all bodies (mass-weighted)
-    glm::dvec2 weightedSum(0.0);
-    double totalMass = 0.0;
-    for (const auto& p : planets) {
-        double m = (double)p.getMass();
-        glm::dvec2 pos((double)p.getP().getX(), (double)p.getP().getY());
-        weightedSum += pos * m; totalMass += m;
-    }
-    glm::vec2 com = (totalMass > 0.0) ? glm::vec2(weightedSum / totalMass) : glm::vec2(0.0f);
-
-    // Compute distances to COM
-    std::vector<float> dists; dists.reserve(planets.size());
-    for (const auto& p : planets) {
-        glm::vec2 pos(p.getP().getX(), p.getP().getY());
-        dists.push_back(glm::length(pos - com));
-    }
-
-    // Median distance
-    std::vector<float> sorted = dists;
-    if (sorted.empty()) return;
-    size_t mid = sorted.size() / 2;
-    std::nth_element(sorted.begin(), sorted.begin() + mid, sorted.end());
-    float median = sorted[mid];
-    if (median <= 0.0f) median = 1e-4f;
-
-    float threshold = outlierMultiplier * median;
-    for (size_t i = 0; i < planets.size(); ++i) {
-        if (dists[i] <= threshold) indices.push_back(i);
-    }
+    // The window coordinates go from -1 to 1, so total size is 2; use the smaller
+    // zoom so everything fits, clamped to reasonable bounds
+    const float optimalZoom = std::min(2.0f / width, 2.0f / height);
+    outZoom = std::clamp(optimalZoom, 0.0005f, 100.0f);
 }
 
 void Camera::reset() {
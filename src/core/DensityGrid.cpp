@@ -0,0 +1,75 @@
+#include "planets/DensityGrid.hpp"
+#include "planets/MemoryTracker.hpp"
+#include "planets/Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+
+std::size_t DensityGrid::memoryBytes() const {
+    std::size_t bytes = capacityBytes(density) + capacityBytes(sparseBodies) + capacityBytes(cellOf) +
+                        capacityBytes(chunkCounts) + capacityBytes(chunkSparse);
+    for (const auto& c : chunkCounts) bytes += capacityBytes(c);
+    for (const auto& c : chunkSparse) bytes += capacityBytes(c);
+    return bytes;
+}
+
+void DensityGrid::build(const std::vector<Planet>& planets, glm::vec2 camPos, float zoom,
+                        int viewportW, int viewportH) {
+    cols = std::max(1, (viewportW + cellPx - 1) / cellPx);
+    rows = std::max(1, (viewportH + cellPx - 1) / cellPx);
+    const std::size_t cellCount = static_cast<std::size_t>(cols) * rows;
+    const std::size_t n = planets.size();
+
+    const unsigned chunks = parallel::maxChunks();
+    if (chunkCounts.size() < chunks) chunkCounts.resize(chunks);
+    if (chunkSparse.size() < chunks) chunkSparse.resize(chunks);
+    cellOf.resize(n);
+
+    // world -> pixel: ((p - camPos) * zoom + 1) * 0.5 * viewport
+    const float sx = zoom * 0.5f * static_cast<float>(viewportW) / static_cast<float>(cellPx);
+    const float sy = zoom * 0.5f * static_cast<float>(viewportH) / static_cast<float>(cellPx);
+    const float ox = 0.5f * static_cast<float>(viewportW) / static_cast<float>(cellPx);
+    const float oy = 0.5f * static_cast<float>(viewportH) / static_cast<float>(cellPx);
+    const std::size_t minPerChunk = 16384;
+
+    // Pass 1: bin into per-chunk grids (no atomics), remembering each body's cell
+    for (auto& counts : chunkCounts) counts.clear(); // keeps capacity; unused chunks stay empty
+    parallel::forRange(n, minPerChunk, [&](std::size_t begin, std::size_t end, unsigned c) {
+        std::vector<std::uint32_t>& counts = chunkCounts[c];
+        counts.assign(cellCount, 0u);
+        for (std::size_t i = begin; i < end; ++i) {
+            const Vector2& p = planets[i].getP();
+            const float fx = (p.getX() - camPos.x) * sx + ox;
+            const float fy = (p.getY() - camPos.y) * sy + oy;
+            if (!(fx >= 0.0f && fy >= 0.0f && fx < static_cast<float>(cols) && fy < static_cast<float>(rows))) {
+                cellOf[i] = -1;
+                continue;
+            }
+            const std::int32_t cell = static_cast<std::int32_t>(fy) * cols + static_cast<std::int32_t>(fx);
+            cellOf[i] = cell;
+            ++counts[cell];
+        }
+    });
+
+    // Reduce chunk grids into the float density texture
+    density.assign(cellCount, 0.0f);
+    parallel::forRange(cellCount, 4096, [&](std::size_t begin, std::size_t end, unsigned) {
+        for (const auto& counts : chunkCounts) {
+            if (counts.empty()) continue;
+            for (std::size_t k = begin; k < end; ++k) density[k] += static_cast<float>(counts[k]);
+        }
+    });
+    maxDensity = density.empty() ? 0.0f : *std::max_element(density.begin(), density.end());
+
+    // Pass 2: collect bodies that sit in sparse cells, preserving body order
+    const float sparse = static_cast<float>(sparseThreshold);
+    for (auto& list : chunkSparse) list.clear();
+    parallel::forRange(n, minPerChunk, [&](std::size_t begin, std::size_t end, unsigned c) {
+        std::vector<std::uint32_t>& list = chunkSparse[c];
+        for (std::size_t i = begin; i < end; ++i) {
+            const std::int32_t cell = cellOf[i];
+            if (cell >= 0 && density[cell] <= sparse) list.push_back(static_cast<std::uint32_t>(i));
+        }
+    });
+    sparseBodies.clear();
+    for (const auto& list : chunkSparse) sparseBodies.insert(sparseBodies.end(), list.begin(), list.end());
+}
@@ -0,0 +1,286 @@
+#include "planets/Diagnostics.hpp"
+#include "planets/MemoryTracker.hpp"
+#include "planets/PhysicsEngine.hpp"
+#include "planets/Profiler.hpp"
+#include "planets/Simulation.hpp"
+#include "planets/Tracer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+Diagnostics::Diagnostics() {
+    worker = std::thread([this] { workerLoop(); });
+}
+
+Diagnostics::~Diagnostics() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_one();
+    if (worker.joinable()) worker.join();
+}
+
+bool Diagnostics::isBusy() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return busy;
+}
+
+std::size_t Diagnostics::memoryBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    // The worker's buffers are only stable while it is idle
+    if (!busy) idleBytes = capacityBytes(jobBodies) + capacityBytes(cells) + capacityBytes(order);
+    return idleBytes;
+}
+
+void Diagnostics::update(const Simulation& sim, double now) {
+    // A restart resets the step count or changes the bodies; drifts start over
+    const std::size_t bodyCount = sim.getPlanets().size();
+    const bool restarted = sim.getStepCount() < lastStepCount || bodyCount != lastBodyCount;
+    lastStepCount = sim.getStepCount();
+    lastBodyCount = bodyCount;
+    if (restarted) {
+        ++generation;
+        historyHead = historyCount = 0;
+        latest = Sample{};
+    }
+
+    collect();
+    if (isBusy() || !enabled || bodyCount == 0) return;
+    if (!restarted && jobGeneration == generation && lastRequest >= 0.0 && now - lastRequest < interval) return;
+    lastRequest = now;
+    submit(sim);
+}
+
+void Diagnostics::flush(const Simulation& sim) {
+    update(sim, lastRequest);
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return !busy; });
+    lock.unlock();
+    collect();
+    if (!enabled || sim.getPlanets().empty()) return;
+    submit(sim);
+    lock.lock();
+    idle.wait(lock, [this] { return !busy; });
+    lock.unlock();
+    collect();
+}
+
+void Diagnostics::collect() {
+    std::lock_guard<std::mutex> lock(mutex);
+    // A result from before a restart is stale
+    if (resultReady && resultGeneration == generation) {
+        latest = result;
+        energyHistory[historyHead] = static_cast<float>(latest.energyDrift);
+        momentumHistory[historyHead] = static_cast<float>(latest.momentumDrift);
+        angularHistory[historyHead] = static_cast<float>(latest.angularDrift);
+        historyHead = (historyHead + 1) % HISTORY;
+        historyCount = std::min(historyCount + 1, HISTORY);
+    }
+    resultReady = false;
+}
+
+void Diagnostics::submit(const Simulation& sim) {
+    // The worker is idle, so the job buffer is ours
+    MemoryTracker::TagScope tag(MemoryTracker::SpatialIndex);
+    const std::vector<Planet>& planets = sim.getPlanets();
+    jobBodies.resize(planets.size());
+    for (std::size_t i = 0; i < planets.size(); ++i) {
+        const Planet& p = planets[i];
+        jobBodies[i] = { p.getMass(), p.getP().getX(), p.getP().getY(), p.getV().getX(), p.getV().getY() };
+    }
+    const std::pair<float, float> gravity = sim.getGravityParams();
+    jobG = gravity.first;
+    jobEps = gravity.second;
+    jobSimTime = sim.getSimTime();
+    jobTheta = theta;
+    jobGeneration = generation;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        busy = true;
+        jobPending = true;
+    }
+    cv.notify_one();
+}
+
+void Diagnostics::workerLoop() {
+    Tracer::get().setThreadName("Diagnostics");
+    MemoryTracker::TagScope tag(MemoryTracker::SpatialIndex);
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return stopping || jobPending; });
+            if (stopping) return;
+            jobPending = false;
+        }
+        evaluate();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            resultReady = true;
+            busy = false;
+        }
+        idle.notify_all();
+    }
+}
+
+void Diagnostics::evaluate() {
+    PLANETS_PROFILE_SCOPE("Diagnostics");
+    const auto start = std::chrono::steady_clock::now();
+    Sample s;
+    s.simTime = jobSimTime;
+    s.bodies = jobBodies.size();
+
+    double momentumMagnitude = 0.0, angularMagnitude = 0.0;
+    for (const Body& b : jobBodies) {
+        s.kinetic += 0.5 * b.m * (b.vx * b.vx + b.vy * b.vy);
+        s.momentumX += b.m * b.vx;
+        s.momentumY += b.m * b.vy;
+        const double l = b.m * (b.x * b.vy - b.y * b.vx);
+        s.angularMomentum += l;
+        momentumMagnitude += b.m * std::hypot(b.vx, b.vy);
+        angularMagnitude += std::fabs(l);
+    }
+    s.potential = jobBodies.size() <= DIRECT_MAX_BODIES ? potentialDirect() : potentialTree();
+    s.energy = s.kinetic + s.potential;
+    s.virialRatio = s.potential != 0.0 ? 2.0 * s.kinetic / std::fabs(s.potential) : 0.0;
+
+    // The first sample of each run is the reference
+    if (!haveReference || referenceGeneration != jobGeneration) {
+        reference = s;
+        momentumScale = momentumMagnitude;
+        angularScale = angularMagnitude;
+        haveReference = true;
+        referenceGeneration = jobGeneration;
+    }
+    auto relative = [](double delta, double scale) { return scale > 0.0 ? std::fabs(delta) / scale : 0.0; };
+    s.energyDrift = relative(s.energy - reference.energy, std::fabs(reference.energy));
+    s.momentumDrift = relative(std::hypot(s.momentumX - reference.momentumX, s.momentumY - reference.momentumY),
+                               momentumScale);
+    s.angularDrift = relative(s.angularMomentum - reference.angularMomentum, angularScale);
+    s.evalMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result = s;
+    resultGeneration = jobGeneration;
+}
+
+double Diagnostics::potentialDirect() const {
+    double u = 0.0;
+    for (std::size_t i = 0; i < jobBodies.size(); ++i) {
+        const Body& a = jobBodies[i];
+        for (std::size_t j = i + 1; j < jobBodies.size(); ++j) {
+            const Body& b = jobBodies[j];
+            u += PhysicsEngine::pairPotential(jobG, jobEps, a.m * b.m, std::hypot(b.x - a.x, b.y - a.y));
+        }
+    }
+    return u;
+}
+
+void Diagnostics::buildCell(std::int32_t index, int depth) {
+    double mass = 0.0, mx = 0.0, my = 0.0;
+    const std::uint32_t first = cells[index].first, count = cells[index].count;
+    for (std::uint32_t k = first; k < first + count; ++k) {
+        const Body& b = jobBodies[order[k]];
+        mass += b.m;
+        mx += b.m * b.x;
+        my += b.m * b.y;
+    }
+    Cell& cell = cells[index];
+    cell.mass = mass;
+    cell.comX = mass > 0.0 ? mx / mass : cell.x0 + 0.5 * cell.size;
+    cell.comY = mass > 0.0 ? my / mass : cell.y0 + 0.5 * cell.size;
+    cell.qxx = cell.qxy = cell.qyy = 0.0;
+    for (std::uint32_t k = first; k < first + count; ++k) {
+        const Body& b = jobBodies[order[k]];
+        const double dx = b.x - cell.comX, dy = b.y - cell.comY;
+        cell.qxx += b.m * (2.0 * dx * dx - dy * dy);
+        cell.qxy += b.m * 3.0 * dx * dy;
+        cell.qyy += b.m * (2.0 * dy * dy - dx * dx);
+    }
+    if (count <= LEAF_BODIES || depth >= MAX_DEPTH) return;
+
+    // Split into quadrants in place: by y, then each half by x
+    const double half = 0.5 * cell.size;
+    const double midX = cell.x0 + half, midY = cell.y0 + half;
+    const double x0 = cell.x0, y0 = cell.y0;
+    std::uint32_t* begin = order.data() + first;
+    std::uint32_t* end = begin + count;
+    std::uint32_t* splitY = std::partition(begin, end, [&](std::uint32_t i) { return jobBodies[i].y < midY; });
+    std::uint32_t* splitLo = std::partition(begin, splitY, [&](std::uint32_t i) { return jobBodies[i].x < midX; });
+    std::uint32_t* splitHi = std::partition(splitY, end, [&](std::uint32_t i) { return jobBodies[i].x < midX; });
+    std::uint32_t* bounds[5] = { begin, splitLo, splitY, splitHi, end };
+
+    const std::int32_t child = static_cast<std::int32_t>(cells.size());
+    cells.resize(cells.size() + 4); // invalidates `cell`
+    cells[index].child = child;
+    for (int q = 0; q < 4; ++q) {
+        Cell& c = cells[child + q];
+        c.x0 = x0 + (q & 1 ? half : 0.0);
+        c.y0 = y0 + (q & 2 ? half : 0.0);
+        c.size = half;
+        c.first = static_cast<std::uint32_t>(bounds[q] - order.data());
+        c.count = static_cast<std::uint32_t>(bounds[q + 1] - bounds[q]);
+    }
+    for (int q = 0; q < 4; ++q) {
+        if (cells[child + q].count > 0) buildCell(child + q, depth + 1);
+    }
+}
+
+double Diagnostics::potentialTree() {
+    const std::size_t n = jobBodies.size();
+    order.resize(n);
+    for (std::size_t i = 0; i < n; ++i) order[i] = static_cast<std::uint32_t>(i);
+
+    double lo[2] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+    double hi[2] = { std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest() };
+    for (const Body& b : jobBodies) {
+        lo[0] = std::min(lo[0], b.x); hi[0] = std::max(hi[0], b.x);
+        lo[1] = std::min(lo[1], b.y); hi[1] = std::max(hi[1], b.y);
+    }
+    cells.clear();
+    cells.emplace_back();
+    cells[0].x0 = lo[0];
+    cells[0].y0 = lo[1];
+    // Slightly enlarged so bodies on the upper edge still fall inside
+    cells[0].size = std::max(std::max(hi[0] - lo[0], hi[1] - lo[1]), 1e-9) * (1.0 + 1e-9);
+    cells[0].count = static_cast<std::uint32_t>(n);
+    buildCell(0, 0);
+
+    // Each body sums its potential against the tree; every pair is seen from both ends
+    const double theta2 = static_cast<double>(jobTheta) * jobTheta;
+    double u = 0.0;
+    std::int32_t stack[4 * MAX_DEPTH + 4];
+    for (std::size_t i = 0; i < n; ++i) {
+        const Body& a = jobBodies[i];
+        double ui = 0.0;
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Cell& c = cells[stack[--top]];
+            if (c.child < 0) {
+                for (std::uint32_t k = c.first; k < c.first + c.count; ++k) {
+                    const std::uint32_t j = order[k];
+                    if (j == i) continue;
+                    const Body& b = jobBodies[j];
+                    ui += PhysicsEngine::pairPotential(jobG, jobEps, a.m * b.m, std::hypot(b.x - a.x, b.y - a.y));
+                }
+                continue;
+            }
+            const double dx = c.comX - a.x, dy = c.comY - a.y;
+            const double d2 = dx * dx + dy * dy;
+            const bool inside = a.x >= c.x0 && a.x < c.x0 + c.size && a.y >= c.y0 && a.y < c.y0 + c.size;
+            if (!inside && c.size * c.size < theta2 * d2) {
+                // Accepted cells are far beyond the softening length, so the quadrupole
+                // term uses the plain 1/r expansion
+                const double d = std::sqrt(d2);
+                const double quad = (c.qxx * dx * dx + 2.0 * c.qxy * dx * dy + c.qyy * dy * dy) / (2.0 * d2 * d2 * d);
+                ui += PhysicsEngine::pairPotential(jobG, jobEps, a.m * c.mass, d) - jobG * a.m * quad;
+                continue;
+            }
+            for (int q = 0; q < 4; ++q) {
+                if (cells[c.child + q].count > 0) stack[top++] = c.child + q;
+            }
+        }
+        u += ui;
+    }
+    return 0.5 * u;
+}
@@ -0,0 +1,28 @@
+#include "planets/DynamicResolution.hpp"
+#include <algorithm>
+#include <cmath>
+
+void DynamicResolution::update(float sceneMs) {
+    smoothedMs = smoothedMs <= 0.0f ? sceneMs : smoothedMs + (sceneMs - smoothedMs) * 0.1f;
+    if (!enabled) return;
+    if (cooldown > 0) {
+        --cooldown;
+        return;
+    }
+
+    float next = scale;
+    if (smoothedMs > targetMs) {
+        // Aim slightly under budget; pixel cost scales with scale^2
+        next = scale * std::sqrt(0.9f * targetMs / smoothedMs);
+        next = std::floor(next / SCALE_STEP) * SCALE_STEP;
+    } else if (smoothedMs < 0.7f * targetMs) {
+        next = scale + SCALE_STEP;
+    }
+    next = std::clamp(next, minScale, 1.0f);
+    if (std::abs(next - scale) < 0.5f * SCALE_STEP) return;
+
+    // Predict the new cost so the average does not have to decay from the old scale
+    smoothedMs *= (next * next) / (scale * scale);
+    scale = next;
+    cooldown = 15;
+}
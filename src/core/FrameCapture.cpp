@@ -0,0 +1,155 @@
+#include "planets/FrameCapture.hpp"
+#include "planets/Profiler.hpp"
+#include <cstring>
+#include <iostream>
+
+bool FrameCapture::start(const std::string& path, int w, int h, int fps) {
+    finish();
+    MemoryTracker::TagScope tag(MemoryTracker::IO);
+    if (w <= 0 || h <= 0) return false;
+    if (!writer.open(path, ImageSequenceWriter::formatFromPath(path), w, h, fps)) return false;
+
+    width = w;
+    height = h;
+    frameBytes = static_cast<std::size_t>(w) * h * 4;
+    framesCaptured = 0;
+
+    glGenBuffers(PBO_COUNT, pbos);
+    for (GLuint pbo : pbos) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(frameBytes), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    head = 0;
+    pending = 0;
+
+    pool.assign(POOL_SIZE, Frame{});
+    freeFrames.clear();
+    for (Frame& f : pool) {
+        f.pixels.resize(frameBytes);
+        freeFrames.push_back(&f);
+    }
+    queue.clear();
+    stopping = false;
+    writerThread = std::thread([this] { writerLoop(); });
+    active = true;
+    return true;
+}
+
+std::size_t FrameCapture::getWriterQueueDepth() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size();
+}
+
+void FrameCapture::collectMemory(MemoryTracker::Report& report) const {
+    if (!active) return;
+    // Pool frames are sized once in start(), so this is safe while the writer runs
+    report.addCpu(MemoryTracker::IO, pool.size() * frameBytes);
+    report.addGpu(MemoryTracker::IO, PBO_COUNT * frameBytes);
+}
+
+void FrameCapture::capture(GLuint framebuffer) {
+    if (!active) return;
+    // Ring full: the oldest readback must be retired before its PBO is reused
+    if (pending == PBO_COUNT) retireOldest(true);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[head]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    fences[head] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    head = (head + 1) % PBO_COUNT;
+    ++pending;
+
+    // Opportunistically retire readbacks that have already completed
+    while (pending > 0) {
+        const int tail = (head - pending + PBO_COUNT) % PBO_COUNT;
+        if (glClientWaitSync(fences[tail], 0, 0) == GL_TIMEOUT_EXPIRED) break;
+        retireOldest(false);
+    }
+}
+
+void FrameCapture::retireOldest(bool wait) {
+    const int tail = (head - pending + PBO_COUNT) % PBO_COUNT;
+    if (wait) {
+        GLenum status = glClientWaitSync(fences[tail], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (status == GL_TIMEOUT_EXPIRED) status = glClientWaitSync(fences[tail], 0, 1000000);
+    }
+    glDeleteSync(fences[tail]);
+    fences[tail] = nullptr;
+    --pending;
+
+    Frame* frame = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        freeCv.wait(lock, [this] { return !freeFrames.empty(); });
+        frame = freeFrames.back();
+        freeFrames.pop_back();
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[tail]);
+    const void* src = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(frameBytes), GL_MAP_READ_BIT);
+    const bool mapped = src != nullptr;
+    if (mapped) {
+        std::memcpy(frame->pixels.data(), src, frameBytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (mapped) {
+            queue.push_back(frame);
+            ++framesCaptured;
+        } else {
+            std::cerr << "FrameCapture: failed to map readback buffer, frame dropped\n";
+            freeFrames.push_back(frame);
+        }
+    }
+    queueCv.notify_one();
+}
+
+void FrameCapture::writerLoop() {
+    Tracer::get().setThreadName("Capture writer");
+    MemoryTracker::TagScope tag(MemoryTracker::IO);
+    for (;;) {
+        Frame* frame = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queueCv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) return; // stopping and drained
+            frame = queue.front();
+            queue.pop_front();
+        }
+        // GL rows are bottom-up; the writer flips while encoding
+        {
+            PLANETS_PROFILE_SCOPE("Encode frame");
+            writer.writeFrame(frame->pixels.data(), static_cast<std::size_t>(width) * 4, true);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            freeFrames.push_back(frame);
+        }
+        freeCv.notify_one();
+    }
+}
+
+void FrameCapture::finish() {
+    if (!active) return;
+    while (pending > 0) retireOldest(true);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queueCv.notify_all();
+    if (writerThread.joinable()) writerThread.join();
+    writer.close();
+
+    glDeleteBuffers(PBO_COUNT, pbos);
+    for (GLuint& pbo : pbos) pbo = 0;
+    pool.clear();
+    freeFrames.clear();
+    active = false;
+}
@@ -0,0 +1,146 @@
+#include "planets/FrameTelemetry.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+namespace {
+float toMs(FrameTelemetry::Clock::duration d) {
+    return std::chrono::duration<float, std::milli>(d).count();
+}
+
+// Nearest-rank percentile of sorted values
+float percentile(const float* sorted, int n, float p) {
+    const int rank = static_cast<int>(std::ceil(p * n)) - 1;
+    return sorted[std::clamp(rank, 0, n - 1)];
+}
+}
+
+FrameTelemetry::FrameTelemetry() {
+    reset();
+}
+
+const char* FrameTelemetry::channelName(Channel c) {
+    switch (c) {
+    case Frame:   return "Frame";
+    case Physics: return "Physics";
+    case Render:  return "Render";
+    case Latency: return "Input latency";
+    default:      return "";
+    }
+}
+
+void FrameTelemetry::reset() {
+    for (auto& channel : history) std::fill(channel, channel + CAPACITY, 0.0f);
+    std::fill(hitch, hitch + CAPACITY, false);
+    std::fill(frameIndex, frameIndex + CAPACITY, 0);
+    head = count = 0;
+    totalFrames = totalHitches = 0;
+    medianFrameMs = 0.0f;
+    framesSinceMedian = 0;
+    inFrame = false;
+    haveLastPresent = false;
+}
+
+void FrameTelemetry::beginFrame() {
+    frameStart = Clock::now();
+    std::fill(current, current + CHANNEL_COUNT, 0.0f);
+    inFrame = true;
+}
+
+void FrameTelemetry::add(Channel c, Clock::duration d) {
+    if (inFrame) current[c] += toMs(d);
+}
+
+void FrameTelemetry::discardFrame() {
+    inFrame = false;
+    haveLastPresent = false;
+}
+
+void FrameTelemetry::endFrame() {
+    if (!inFrame) return;
+    inFrame = false;
+    const Clock::time_point present = Clock::now();
+    const float workMs = toMs(present - frameStart);
+    // After a break the interval is unknown; the frame's own time stands in for it
+    const float intervalMs = haveLastPresent ? toMs(present - lastPresent) : workMs;
+    const float latencyMs = workMs + (haveLastPresent ? 0.5f * prevIntervalMs : 0.0f);
+    lastPresent = present;
+    prevIntervalMs = intervalMs;
+    haveLastPresent = true;
+
+    history[Frame][head] = intervalMs;
+    history[Physics][head] = current[Physics];
+    history[Render][head] = current[Render];
+    history[Latency][head] = latencyMs;
+    frameIndex[head] = totalFrames++;
+    if (count < CAPACITY) ++count;
+
+    if (++framesSinceMedian >= MEDIAN_REFRESH || medianFrameMs <= 0.0f) {
+        medianFrameMs = getStats(Frame).p50Ms;
+        framesSinceMedian = 0;
+    }
+    // Need a few frames before the median means anything
+    hitch[head] = count >= 8 && intervalMs > HITCH_FACTOR * medianFrameMs;
+    if (hitch[head]) ++totalHitches;
+    head = (head + 1) % CAPACITY;
+}
+
+int FrameTelemetry::sortedChannel(Channel c, float* out) const {
+    std::copy(history[c], history[c] + count, out);
+    std::sort(out, out + count);
+    return count;
+}
+
+FrameTelemetry::Stats FrameTelemetry::getStats(Channel c) const {
+    Stats s;
+    if (count == 0) return s;
+    float sorted[CAPACITY];
+    const int n = sortedChannel(c, sorted);
+    double sum = 0.0;
+    for (int i = 0; i < n; ++i) sum += sorted[i];
+    s.avgMs = static_cast<float>(sum / n);
+    s.p50Ms = percentile(sorted, n, 0.50f);
+    s.p95Ms = percentile(sorted, n, 0.95f);
+    s.p99Ms = percentile(sorted, n, 0.99f);
+    s.maxMs = sorted[n - 1];
+    return s;
+}
+
+int FrameTelemetry::getRecentHitches() const {
+    return static_cast<int>(std::count(hitch, hitch + count, true));
+}
+
+bool FrameTelemetry::exportCsv(const std::string& path) const {
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) {
+        std::cerr << "FrameTelemetry: cannot open " << path << "\n";
+        return false;
+    }
+    std::fprintf(f, "frame,frame_ms,physics_ms,render_ms,latency_ms,hitch\n");
+    for (int k = 0; k < count; ++k) {
+        const int i = (getOffset() + k) % CAPACITY;
+        std::fprintf(f, "%llu,%.4f,%.4f,%.4f,%.4f,%d\n", static_cast<unsigned long long>(frameIndex[i]),
+                     history[Frame][i], history[Physics][i], history[Render][i], history[Latency][i],
+                     hitch[i] ? 1 : 0);
+    }
+    const bool ok = std::fclose(f) == 0;
+    if (!ok) std::cerr << "FrameTelemetry: failed writing " << path << "\n";
+    return ok;
+}
+
+std::string FrameTelemetry::summary() const {
+    char line[160];
+    std::snprintf(line, sizeof(line), "Frame times over the last %d frames:\n", count);
+    std::string out = line;
+    for (int c = 0; c < CHANNEL_COUNT; ++c) {
+        const Stats s = getStats(static_cast<Channel>(c));
+        std::snprintf(line, sizeof(line), "%-14s avg %7.2f  p50 %7.2f  p95 %7.2f  p99 %7.2f  max %7.2f ms\n",
+                      channelName(static_cast<Channel>(c)), s.avgMs, s.p50Ms, s.p95Ms, s.p99Ms, s.maxMs);
+        out += line;
+    }
+    std::snprintf(line, sizeof(line), "Hitches (> %.1fx median): %llu of %llu frames\n", HITCH_FACTOR,
+                  static_cast<unsigned long long>(totalHitches), static_cast<unsigned long long>(totalFrames));
+    out += line;
+    return out;
+}
@@ -1,12 +1,19 @@
 #include "planets/Renderer.hpp"
 #include "planets/GUI.hpp"
+#include "planets/Profiler.hpp"
+#include "planets/PerfCounters.hpp"
+#include "planets/MemoryTracker.hpp"
+#include "planets/Kernels.hpp"
 #include <imgui.h>
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_opengl3.h>
+#include <algorithm>
 #include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <cstdio>
 
 GUI::GUI() {
-    fpsHistory.clear();
 }
 
 GUI::~GUI() {
@@ -37,20 +44,22 @@ void GUI::newFrame() {
 }
 
 void GUI::render(Simulation& sim, Camera& camera, Renderer& renderer, float deltaTime) {
+    PLANETS_PROFILE_SCOPE("ImGui");
+    MemoryTracker::TagScope tag(MemoryTracker::UI);
+    // Main-thread allocations between consecutive GUI renders, i.e. over one frame
+    const std::uint64_t allocations = MemoryTracker::threadAllocations();
+    lastFrameAllocations = allocations - frameAllocationsStart;
+    frameAllocationsStart = allocations;
+    PassTimer& timer = renderer.getPassTimer();
+    if (imguiPass < 0) imguiPass = timer.addPass("ImGui");
+    drawSelectionOverlay(sim, camera);
     if (!visible) {
         ImGui::Render();
+        PassTimer::Scope timed(timer, imguiPass);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         return;
     }
     
-    // Calculate FPS
-    float fps = (deltaTime > 0.0f) ? (1.0f / deltaTime) : 0.0f;
-    fpsHistory.push_back(fps);
-    if (fpsHistory.size() > FPS_HISTORY_SIZE) {
-        fpsHistory.pop_front();
-    }
-    lastFPS = fps;
-    
     auto& planets = sim.getPlanets();
     lastPlanetCount = static_cast<int>(planets.size());
     
@@ -63,23 +72,88 @@ void GUI::render(Simulation& sim, Camera& camera, Renderer& renderer, float delt
     if (ImGui::Begin("Simulation Control", &visible, flags)) {
         // === STATS SECTION ===
         if (ImGui::CollapsingHeader("Statistics", ImGuiTreeNodeFlags_DefaultOpen)) {
-            ImGui::Text("FPS: %.1f", lastFPS);
-            
-            // FPS graph
-            float fpsArray[FPS_HISTORY_SIZE];
-            size_t count = std::min(fpsHistory.size(), FPS_HISTORY_SIZE);
-            for (size_t i = 0; i < count; ++i) {
-                fpsArray[i] = fpsHistory[i];
-            }
-            ImGui::PlotLines("##FPS", fpsArray, static_cast<int>(count), 0, nullptr, 0.0f, 120.0f, ImVec2(0, 50));
-            
+            drawFrameTimes(deltaTime);
+
             ImGui::Separator();
             ImGui::Text("Bodies: %d", lastPlanetCount);
             ImGui::Text("Zoom: %.3f", camera.getZoom());
+            ImGui::Text("Kernels: %s", kernels::isaName(kernels::active().isa));
+
+            // Per-pass timings; GPU times lag a few frames behind
+            if (ImGui::BeginTable("PassTimes", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+                ImGui::TableSetupColumn("Pass", ImGuiTableColumnFlags_WidthStretch);
+                ImGui::TableSetupColumn("GPU ms");
+                ImGui::TableSetupColumn("CPU ms");
+                ImGui::TableHeadersRow();
+                float gpuTotal = 0.0f, cpuTotal = 0.0f;
+                for (int i = 0; i < timer.getPassCount(); ++i) {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(timer.getPassName(i));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", timer.getGpuMs(i));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", timer.getCpuMs(i));
+                    gpuTotal += timer.getGpuMs(i);
+                    cpuTotal += timer.getCpuMs(i);
+                }
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextDisabled("Total");
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", gpuTotal);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", cpuTotal);
+                ImGui::EndTable();
+            }
         }
         
+        ImGui::Spacing();
+
+        // === SELECTION SECTION ===
+        if (selection && !selection->selected.empty() &&
+            ImGui::CollapsingHeader("Selection", ImGuiTreeNodeFlags_DefaultOpen)) {
+            double mass = 0.0, mx = 0.0, my = 0.0;
+            size_t count = 0;
+            for (std::uint32_t i : selection->selected) {
+                if (i >= planets.size()) continue;
+                const Planet& p = planets[i];
+                mass += p.getMass();
+                mx += static_cast<double>(p.getMass()) * p.getP().getX();
+                my += static_cast<double>(p.getMass()) * p.getP().getY();
+                ++count;
+            }
+            ImGui::Text("Selected: %zu bodies", count);
+            ImGui::Text("Total mass: %.4g", mass);
+            if (mass > 0.0) {
+                ImGui::Text("COM: (%.3f, %.3f)", mx / mass, my / mass);
+            }
+            ImGui::TextDisabled("Shift+drag to select, Shift+click to clear");
+        }
+
         ImGui::Spacing();
         
+        // === PROFILER SECTION ===
+        if (ImGui::CollapsingHeader("Profiler")) {
+            drawProfiler();
+        }
+
+        ImGui::Spacing();
+
+        // === DIAGNOSTICS SECTION ===
+        if (diagnostics && ImGui::CollapsingHeader("Diagnostics")) {
+            drawDiagnostics();
+        }
+
+        ImGui::Spacing();
+
+        // === MEMORY SECTION ===
+        if (ImGui::CollapsingHeader("Memory")) {
+            drawMemory(sim, renderer);
+        }
+
+        ImGui::Spacing();
+
         // === CONTROLS SECTION ===
         if (ImGui::CollapsingHeader("Controls", ImGuiTreeNodeFlags_DefaultOpen)) {
             // Pause/Play
@@ -112,6 +186,27 @@ void GUI::render(Simulation& sim, Camera& camera, Renderer& renderer, float delt
                 sim.setGravityParams(BASE_GRAVITY * gravityMultiplier, BASE_SOFTENING * softeningMultiplier);
             }
             
+            ImGui::Separator();
+
+            // Trails: toggling off also stops sampling so it costs nothing
+            bool trailsOn = renderer.areTrailsEnabled();
+            if (ImGui::Checkbox("Trails", &trailsOn)) {
+                renderer.setTrailsEnabled(trailsOn);
+                sim.getTrails().setEnabled(trailsOn);
+                if (!trailsOn) sim.clearTrails();
+            }
+            float trailInterval = static_cast<float>(sim.getTrails().getSampleInterval() * 1000.0);
+            if (ImGui::SliderFloat("Trail Cadence", &trailInterval, 0.5f, 50.0f, "%.1f ms sim")) {
+                sim.getTrails().setSampleInterval(trailInterval / 1000.0);
+            }
+            float trailTolerance = sim.getTrails().getTolerance() * 1000.0f;
+            if (ImGui::SliderFloat("Trail Tolerance", &trailTolerance, 0.0f, 20.0f, "%.1f e-3")) {
+                sim.getTrails().setTolerance(trailTolerance / 1000.0f);
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Maximum deviation (world units) of a dropped trail sample from the kept chord");
+            }
+
             ImGui::Separator();
             
             // Collisions removed from UI
@@ -122,22 +217,21 @@ void GUI::render(Simulation& sim, Camera& camera, Renderer& renderer, float delt
         // === SIMULATION SECTION ===
         if (ImGui::CollapsingHeader("Simulation", ImGuiTreeNodeFlags_DefaultOpen)) {
             if (ImGui::Button("Reinitialize (12 bodies)", ImVec2(-1, 0))) {
+                // Reinitializing also resets the simulation's trails
                 sim.initRandom(12, static_cast<unsigned>(ImGui::GetTime() * 1000));
-                // Clear both renderer-managed trails and per-planet trails
-                renderer.clearTrails();
-                for (auto &p : sim.getPlanets()) p.clearTrail();
                 camera.reset();
                 restartTriggered = true;
             }
             
             static int bodyCount = 20;
-            ImGui::InputInt("Body Count", &bodyCount);
-            bodyCount = std::max(1, std::min(bodyCount, 200));
+            ImGui::InputInt("Body Count", &bodyCount, 10, 1000);
+            bodyCount = std::max(1, std::min(bodyCount, MAX_CUSTOM_BODIES));
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Gravity is computed pairwise; pause to inspect very large systems");
+            }
             
             if (ImGui::Button("Create Custom Simulation", ImVec2(-1, 0))) {
                 sim.initRandom(bodyCount, static_cast<unsigned>(ImGui::GetTime() * 1000));
-                renderer.clearTrails();
-                for (auto &p : sim.getPlanets()) p.clearTrail();
                 camera.reset();
                 restartTriggered = true;
             }
@@ -145,6 +239,13 @@ void GUI::render(Simulation& sim, Camera& camera, Renderer& renderer, float delt
         
         ImGui::Spacing();
         
+        // === BODIES SECTION ===
+        if (ImGui::CollapsingHeader("Bodies")) {
+            drawBodyTable(sim, camera);
+        }
+
+        ImGui::Spacing();
+
         // === CAMERA SECTION ===
         if (ImGui::CollapsingHeader("Camera", ImGuiTreeNodeFlags_DefaultOpen)) {
             float zoomSpeed = 0.1f;
@@ -167,6 +268,51 @@ void GUI::render(Simulation& sim, Camera& camera, Renderer& renderer, float delt
             }
         }
         
+        ImGui::Spacing();
+
+        // === RENDERING SECTION ===
+        if (ImGui::CollapsingHeader("Rendering")) {
+            static const char* lodModes[] = { "Sprites", "Density", "Auto" };
+            int lodMode = static_cast<int>(renderer.getPlanetRenderMode());
+            if (ImGui::Combo("Planet LOD", &lodMode, lodModes, IM_ARRAYSIZE(lodModes))) {
+                renderer.setPlanetRenderMode(static_cast<PlanetRenderMode>(lodMode));
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Density draws crowded regions as a heatmap; Auto switches at the body threshold");
+            }
+
+            DensityGrid& grid = renderer.getDensityGrid();
+            int cellPx = grid.getCellSize();
+            if (ImGui::SliderInt("Density Cell", &cellPx, 1, 16, "%d px")) {
+                grid.setCellSize(cellPx);
+            }
+            int sparse = static_cast<int>(grid.getSparseThreshold());
+            if (ImGui::SliderInt("Sprite Threshold", &sparse, 0, 64)) {
+                grid.setSparseThreshold(static_cast<std::uint32_t>(sparse));
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Cells holding at most this many bodies draw them as individual sprites");
+            }
+
+            DynamicResolution& dynres = renderer.getDynamicResolution();
+            bool dynOn = dynres.isEnabled();
+            if (ImGui::Checkbox("Dynamic Resolution", &dynOn)) {
+                dynres.setEnabled(dynOn);
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Render the simulation at reduced resolution when it exceeds the GPU budget");
+            }
+            float targetMs = dynres.getTargetMs();
+            if (ImGui::SliderFloat("Scene Budget", &targetMs, 2.0f, 33.0f, "%.1f ms")) {
+                dynres.setTargetMs(targetMs);
+            }
+            float minScale = dynres.getMinScale();
+            if (ImGui::SliderFloat("Min Scale", &minScale, 0.25f, 1.0f, "%.2f")) {
+                dynres.setMinScale(minScale);
+            }
+            ImGui::Text("Scene: %.2f ms GPU at %.0f%% scale", dynres.getPassMs(), dynres.getScale() * 100.0f);
+        }
+
         ImGui::Spacing();
         ImGui::Separator();
     }
@@ -174,9 +320,385 @@ void GUI::render(Simulation& sim, Camera& camera, Renderer& renderer, float delt
     
     // Render ImGui
     ImGui::Render();
+    PassTimer::Scope timed(timer, imguiPass);
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
+void GUI::drawSelectionOverlay(const Simulation& sim, const Camera& camera) {
+    if (!selection) return;
+    const std::vector<Planet>& planets = sim.getPlanets();
+    ImDrawList* draw = ImGui::GetForegroundDrawList();
+
+    if (selection->dragging) {
+        const ImVec2 a(selection->dragStart.x, selection->dragStart.y);
+        const ImVec2 b(selection->dragEnd.x, selection->dragEnd.y);
+        draw->AddRectFilled(ImVec2(std::min(a.x, b.x), std::min(a.y, b.y)),
+                            ImVec2(std::max(a.x, b.x), std::max(a.y, b.y)), IM_COL32(90, 150, 255, 40));
+        draw->AddRect(ImVec2(std::min(a.x, b.x), std::min(a.y, b.y)),
+                      ImVec2(std::max(a.x, b.x), std::max(a.y, b.y)), IM_COL32(90, 150, 255, 200));
+    }
+
+    // Markers: project to window coordinates through the same mapping as the view
+    ImGuiIO& io = ImGui::GetIO();
+    const float left = visible ? static_cast<float>(PANEL_WIDTH) : 0.0f;
+    const float w = std::max(io.DisplaySize.x - left, 1.0f);
+    const float h = std::max(io.DisplaySize.y, 1.0f);
+    const glm::vec2 camPos = camera.getPosition();
+    const float zoom = camera.getZoom();
+    const size_t markers = std::min(selection->selected.size(), MAX_SELECTION_MARKERS);
+    for (size_t k = 0; k < markers; ++k) {
+        const std::uint32_t i = selection->selected[k];
+        if (i >= planets.size()) continue;
+        const float ndcX = (planets[i].getP().getX() - camPos.x) * zoom;
+        const float ndcY = (planets[i].getP().getY() - camPos.y) * zoom;
+        if (std::abs(ndcX) > 1.0f || std::abs(ndcY) > 1.0f) continue;
+        const ImVec2 c(left + (ndcX + 1.0f) * 0.5f * w, (1.0f - ndcY) * 0.5f * h);
+        draw->AddCircle(c, 6.0f, IM_COL32(90, 150, 255, 220));
+    }
+
+    const int hovered = selection->hovered;
+    if (hovered >= 0 && static_cast<size_t>(hovered) < planets.size()) {
+        const Planet& p = planets[hovered];
+        const float speed = std::sqrt(p.getV().getX() * p.getV().getX() + p.getV().getY() * p.getV().getY());
+        ImGui::BeginTooltip();
+        ImGui::Text("Body %d%s", hovered, camera.getFollowedPlanet() == hovered ? " (followed)" : "");
+        ImGui::Text("Mass: %.4g", p.getMass());
+        ImGui::Text("Position: (%.3f, %.3f)", p.getP().getX(), p.getP().getY());
+        ImGui::Text("Speed: %.4f", speed);
+        ImGui::EndTooltip();
+    }
+}
+
+void GUI::drawBodyTable(const Simulation& sim, Camera& camera) {
+    const std::vector<Planet>& planets = sim.getPlanets();
+
+    ImGui::Checkbox("Filter", &inspectorFilter);
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Show only rows whose value in the sorted column lies in [Min, Max]");
+    }
+    if (inspectorFilter) {
+        ImGui::InputFloat("Min", &inspectorLo, 0.0f, 0.0f, "%.4g");
+        ImGui::InputFloat("Max", &inspectorHi, 0.0f, 0.0f, "%.4g");
+    }
+    inspector.setFilter(inspectorFilter, inspectorLo, inspectorHi);
+
+    const ImGuiTableFlags flags = ImGuiTableFlags_Sortable | ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg |
+                                  ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_Resizable;
+    if (ImGui::BeginTable("Bodies", BodyInspector::COLUMN_COUNT, flags, ImVec2(0.0f, 300.0f))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Id", ImGuiTableColumnFlags_DefaultSort, 0.0f, BodyInspector::Id);
+        ImGui::TableSetupColumn("Mass", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, BodyInspector::Mass);
+        ImGui::TableSetupColumn("X", 0, 0.0f, BodyInspector::PosX);
+        ImGui::TableSetupColumn("Y", 0, 0.0f, BodyInspector::PosY);
+        ImGui::TableSetupColumn("Speed", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, BodyInspector::Speed);
+        ImGui::TableSetupColumn("KE", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, BodyInspector::Energy);
+        ImGui::TableHeadersRow();
+
+        if (ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs()) {
+            if (specs->SpecsCount > 0) {
+                inspector.setSort(static_cast<BodyInspector::Column>(specs->Specs[0].ColumnUserID),
+                                  specs->Specs[0].SortDirection == ImGuiSortDirection_Descending);
+            }
+            specs->SpecsDirty = false;
+        }
+        inspector.update(sim, ImGui::GetTime());
+
+        // Only the visible rows are formatted; values are live, the order may lag slightly
+        const std::vector<std::uint32_t>& order = inspector.getOrder();
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(order.size()));
+        while (clipper.Step()) {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+                const std::uint32_t i = order[row];
+                if (i >= planets.size()) continue;
+                const Planet& p = planets[i];
+                const float vx = p.getV().getX(), vy = p.getV().getY();
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::PushID(static_cast<int>(i));
+                char label[16];
+                std::snprintf(label, sizeof(label), "%u", i);
+                // Clicking a row follows the body, as double-clicking it in the view does
+                if (ImGui::Selectable(label, camera.getFollowedPlanet() == static_cast<int>(i),
+                                      ImGuiSelectableFlags_SpanAllColumns)) {
+                    camera.setFollowedPlanet(camera.getFollowedPlanet() == static_cast<int>(i) ? -1 : static_cast<int>(i));
+                }
+                ImGui::PopID();
+                ImGui::TableNextColumn();
+                ImGui::Text("%.4g", p.getMass());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", p.getP().getX());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", p.getP().getY());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.4f", BodyInspector::columnValue(BodyInspector::Speed, i, p.getMass(), 0, 0, vx, vy));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.4g", BodyInspector::columnValue(BodyInspector::Energy, i, p.getMass(), 0, 0, vx, vy));
+            }
+        }
+        clipper.End();
+        ImGui::EndTable();
+    }
+    ImGui::TextDisabled("%zu of %zu rows%s", inspector.getOrder().size(), planets.size(),
+                        inspector.isBusy() ? ", sorting..." : "");
+}
+
+void GUI::drawProfiler() {
+#ifndef PLANETS_PROFILING
+    ImGui::TextDisabled("Built without PLANETS_PROFILING");
+#else
+    Profiler& profiler = Profiler::get();
+    bool enabled = profiler.isEnabled();
+    if (ImGui::Checkbox("Record", &enabled)) {
+        profiler.setEnabled(enabled);
+    }
+    ImGui::SameLine();
+    Tracer& tracer = Tracer::get();
+    if (tracer.isCapturing()) {
+        ImGui::TextDisabled("Tracing...");
+    } else if (ImGui::SmallButton("Capture Trace")) {
+        tracer.capture(TRACE_PATH, TRACE_FRAMES);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Record the next %d frames from all threads to %s (chrome://tracing, Perfetto)",
+                          TRACE_FRAMES, TRACE_PATH);
+    }
+    if (profilerNode >= profiler.getNodeCount()) profilerNode = 0;
+    ImGui::SameLine();
+    ImGui::TextDisabled("%s, last %d frames", profiler.getName(profilerNode), profiler.getHistoryCount());
+    ImGui::PlotLines("##ProfilerHistory", profiler.getHistory(profilerNode), profiler.getHistoryCount(),
+                     profiler.getHistoryOffset(), nullptr, 0.0f, FLT_MAX, ImVec2(0, 50));
+
+    const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingFixedFit;
+    if (ImGui::BeginTable("Profiler", 5, flags)) {
+        ImGui::TableSetupColumn("Scope (ms)", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Avg");
+        ImGui::TableSetupColumn("Min");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableHeadersRow();
+        drawProfilerNode(profiler, 0);
+        ImGui::EndTable();
+    }
+#endif
+    drawPerfCounters();
+}
+
+void GUI::drawPerfCounters() {
+    PerfCounters& pc = PerfCounters::get();
+    bool countersOn = pc.isEnabled();
+    if (ImGui::Checkbox("Hardware Counters", &countersOn)) {
+        pc.setEnabled(countersOn);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("perf_event_open counters around the force and integrate kernels");
+    }
+    if (!pc.getError().empty()) {
+        ImGui::TextDisabled("%s", pc.getError().c_str());
+    }
+    if (!pc.isEnabled()) return;
+    pc.update(ImGui::GetTime());
+
+    // Per unit of work: a pair interaction for Forces, a body for Integrate
+    if (ImGui::BeginTable("PerfCounters", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Region", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("IPC");
+        ImGui::TableSetupColumn("Cyc/op");
+        ImGui::TableSetupColumn("L1D/op");
+        ImGui::TableSetupColumn("LLC/op");
+        ImGui::TableHeadersRow();
+        for (int r = 0; r < PerfCounters::REGION_COUNT; ++r) {
+            if (r == PerfCounters::Benchmark) continue; // only planets_bench counts it
+            const PerfCounters::Totals& t = pc.getWindow(static_cast<PerfCounters::Region>(r));
+            const double work = t.work > 0 ? static_cast<double>(t.work) : 1.0;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(PerfCounters::regionName(static_cast<PerfCounters::Region>(r)));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", t.values[PerfCounters::Cycles] ?
+                static_cast<double>(t.values[PerfCounters::Instructions]) / t.values[PerfCounters::Cycles] : 0.0);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", t.values[PerfCounters::Cycles] / work);
+            ImGui::TableNextColumn();
+            if (pc.isAvailable(PerfCounters::L1dMisses)) ImGui::Text("%.3f", t.values[PerfCounters::L1dMisses] / work);
+            else ImGui::TextDisabled("n/a");
+            ImGui::TableNextColumn();
+            if (pc.isAvailable(PerfCounters::CacheMisses)) ImGui::Text("%.4f", t.values[PerfCounters::CacheMisses] / work);
+            else ImGui::TextDisabled("n/a");
+        }
+        ImGui::EndTable();
+    }
+    const PerfCounters::Totals& forces = pc.getWindow(PerfCounters::Forces);
+    if (forces.nanos > 0) {
+        ImGui::Text("Forces: %.2f GFLOP/s (est. %.0f flops/pair)",
+                    forces.work * PerfCounters::PAIR_FLOPS / forces.nanos, PerfCounters::PAIR_FLOPS);
+    }
+}
+
+void GUI::drawFrameTimes(float deltaTime) {
+    if (!telemetry || telemetry->getCount() == 0) {
+        ImGui::Text("FPS: %.1f", deltaTime > 0.0f ? 1.0f / deltaTime : 0.0f);
+        return;
+    }
+    const float frameMs = telemetry->getLastMs(FrameTelemetry::Frame);
+    ImGui::Text("FPS: %.1f (%.2f ms)", frameMs > 0.0f ? 1000.0f / frameMs : 0.0f, frameMs);
+
+    const FrameTelemetry::Stats frame = telemetry->getStats(FrameTelemetry::Frame);
+    char overlay[48];
+    std::snprintf(overlay, sizeof(overlay), "p99 %.1f ms", frame.p99Ms);
+    ImGui::PlotLines("##FrameTimes", telemetry->getHistory(FrameTelemetry::Frame), telemetry->getCount(),
+                     telemetry->getOffset(), overlay, 0.0f, std::max(frame.maxMs, 1.0f), ImVec2(0, 50));
+
+    if (ImGui::BeginTable("FrameStats", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("ms", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("p50");
+        ImGui::TableSetupColumn("p95");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableSetupColumn("max");
+        ImGui::TableHeadersRow();
+        for (int c = 0; c < FrameTelemetry::CHANNEL_COUNT; ++c) {
+            const FrameTelemetry::Channel channel = static_cast<FrameTelemetry::Channel>(c);
+            const FrameTelemetry::Stats s = c == FrameTelemetry::Frame ? frame : telemetry->getStats(channel);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(FrameTelemetry::channelName(channel));
+            for (float v : { s.p50Ms, s.p95Ms, s.p99Ms, s.maxMs }) {
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", v);
+            }
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Text("Hitches: %d in last %d frames", telemetry->getRecentHitches(), telemetry->getCount());
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Frames longer than %.1fx the median frame time", FrameTelemetry::HITCH_FACTOR);
+    }
+    if (ImGui::Button("Export CSV")) {
+        telemetry->exportCsv(FRAME_CSV_PATH);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Writes the last %d frames to %s", telemetry->getCount(), FRAME_CSV_PATH);
+    }
+}
+
+void GUI::drawDiagnostics() {
+    bool enabled = diagnostics->isEnabled();
+    if (ImGui::Checkbox("Enabled", &enabled)) diagnostics->setEnabled(enabled);
+    float interval = static_cast<float>(diagnostics->getInterval());
+    if (ImGui::SliderFloat("Interval (s)", &interval, 0.1f, 5.0f, "%.1f")) diagnostics->setInterval(interval);
+    float theta = diagnostics->getTheta();
+    if (ImGui::SliderFloat("Theta", &theta, 0.2f, 1.0f, "%.2f")) diagnostics->setTheta(theta);
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Barnes-Hut opening angle above %zu bodies; smaller is more accurate",
+                          Diagnostics::DIRECT_MAX_BODIES);
+    }
+    if (!diagnostics->hasSample()) {
+        ImGui::TextDisabled(enabled ? "Waiting for the first sample..." : "Disabled");
+        return;
+    }
+
+    const Diagnostics::Sample& s = diagnostics->getLatest();
+    ImGui::Text("t = %.3f, %zu bodies, %.1f ms", s.simTime, s.bodies, s.evalMs);
+    ImGui::Text("E = %.6g (K %.4g, U %.4g)", s.energy, s.kinetic, s.potential);
+    ImGui::Text("P = (%.4g, %.4g), L = %.6g", s.momentumX, s.momentumY, s.angularMomentum);
+    ImGui::Text("Virial 2K/|U| = %.4f", s.virialRatio);
+
+    struct Series { const char* label; const float* values; double latest; };
+    const Series series[] = {
+        { "Energy drift", diagnostics->getEnergyHistory(), s.energyDrift },
+        { "Momentum drift", diagnostics->getMomentumHistory(), s.momentumDrift },
+        { "Angular momentum drift", diagnostics->getAngularHistory(), s.angularDrift },
+    };
+    const int count = diagnostics->getHistoryCount();
+    for (const Series& d : series) {
+        float top = 0.0f;
+        for (int i = 0; i < count; ++i) top = std::max(top, d.values[i]);
+        char overlay[64];
+        std::snprintf(overlay, sizeof(overlay), "%s %.2e", d.label, d.latest);
+        ImGui::PlotLines(d.label, d.values, count, diagnostics->getHistoryOffset(), overlay, 0.0f,
+                         top > 0.0f ? top : 1e-12f, ImVec2(0, 40));
+    }
+}
+
+void GUI::drawMemory(const Simulation& sim, const Renderer& renderer) {
+    const double now = ImGui::GetTime();
+    if (memoryUpdated < 0.0 || now - memoryUpdated >= MEMORY_REFRESH) {
+        memoryReport = MemoryTracker::Report{};
+        sim.collectMemory(memoryReport);
+        renderer.collectMemory(memoryReport);
+        memoryReport.addCpu(MemoryTracker::UI, inspector.memoryBytes());
+        memoryReport.addCpu(MemoryTracker::IO, Tracer::get().memoryBytes());
+        if (diagnostics) memoryReport.addCpu(MemoryTracker::SpatialIndex, diagnostics->memoryBytes());
+        const float elapsed = memoryUpdated < 0.0 ? 0.0f : static_cast<float>(now - memoryUpdated);
+        for (int t = 0; t < MemoryTracker::TAG_COUNT; ++t) {
+            const MemoryTracker::Traffic traffic = MemoryTracker::getTraffic(static_cast<MemoryTracker::Tag>(t));
+            allocationRate[t] = elapsed > 0.0f ? (traffic.allocations - memoryTraffic[t].allocations) / elapsed : 0.0f;
+            memoryTraffic[t] = traffic;
+        }
+        memoryUpdated = now;
+    }
+
+    const bool tracking = MemoryTracker::isTracking();
+    std::size_t cpuTotal = 0, gpuTotal = 0;
+    if (ImGui::BeginTable("Memory", tracking ? 4 : 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Subsystem", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("CPU");
+        ImGui::TableSetupColumn("GPU");
+        if (tracking) ImGui::TableSetupColumn("Allocs/s");
+        ImGui::TableHeadersRow();
+        for (int t = 0; t < MemoryTracker::TAG_COUNT; ++t) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(MemoryTracker::tagName(static_cast<MemoryTracker::Tag>(t)));
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(MemoryTracker::formatBytes(memoryReport.cpu[t]).c_str());
+            ImGui::TableNextColumn();
+            if (memoryReport.gpu[t] > 0) ImGui::TextUnformatted(MemoryTracker::formatBytes(memoryReport.gpu[t]).c_str());
+            else ImGui::TextDisabled("-");
+            if (tracking) {
+                ImGui::TableNextColumn();
+                ImGui::Text("%.0f", allocationRate[t]);
+            }
+            cpuTotal += memoryReport.cpu[t];
+            gpuTotal += memoryReport.gpu[t];
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Text("Total: %s CPU, %s GPU", MemoryTracker::formatBytes(cpuTotal).c_str(),
+                MemoryTracker::formatBytes(gpuTotal).c_str());
+    if (tracking) {
+        ImGui::Text("Main thread: %llu allocations last frame", static_cast<unsigned long long>(lastFrameAllocations));
+    } else {
+        ImGui::TextDisabled("Allocation counts need -DPLANETS_ALLOCATION_TRACKING=ON");
+    }
+}
+
+void GUI::drawProfilerNode(const Profiler& profiler, int node) {
+    const Profiler::Stats s = profiler.getStats(node);
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    const int child = profiler.getFirstChild(node);
+    ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_DefaultOpen | ImGuiTreeNodeFlags_SpanFullWidth;
+    if (child < 0) flags |= ImGuiTreeNodeFlags_Leaf;
+    const bool open = ImGui::TreeNodeEx(reinterpret_cast<const void*>(static_cast<std::intptr_t>(node)), flags,
+                                        "%s", profiler.getName(node));
+    // Clicking a scope shows its history in the plot
+    if (ImGui::IsItemClicked()) profilerNode = node;
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", s.avgMs);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", s.minMs);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", s.p99Ms);
+    ImGui::TableNextColumn();
+    ImGui::Text("%u", s.calls);
+    if (!open) return;
+    for (int c = child; c >= 0; c = profiler.getNextSibling(c)) {
+        drawProfilerNode(profiler, c);
+    }
+    ImGui::TreePop();
+}
+
 bool GUI::wantsCaptureMouse() const {
     ImGuiIO& io = ImGui::GetIO();
     return io.WantCaptureMouse;
@@ -0,0 +1,228 @@
+#include "planets/ImageWriter.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <iostream>
+
+namespace {
+
+std::uint32_t crc32(const std::uint8_t* data, std::size_t len, std::uint32_t crc = 0) {
+    static const std::array<std::uint32_t, 256> table = [] {
+        std::array<std::uint32_t, 256> t{};
+        for (std::uint32_t n = 0; n < 256; ++n) {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (std::size_t i = 0; i < len; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void putBE32(std::vector<std::uint8_t>& out, std::uint32_t v) {
+    out.push_back(static_cast<std::uint8_t>(v >> 24));
+    out.push_back(static_cast<std::uint8_t>(v >> 16));
+    out.push_back(static_cast<std::uint8_t>(v >> 8));
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+void writeChunk(std::FILE* f, const char* type, const std::uint8_t* data, std::size_t len) {
+    std::uint8_t header[8] = {
+        static_cast<std::uint8_t>(len >> 24), static_cast<std::uint8_t>(len >> 16),
+        static_cast<std::uint8_t>(len >> 8), static_cast<std::uint8_t>(len),
+        static_cast<std::uint8_t>(type[0]), static_cast<std::uint8_t>(type[1]),
+        static_cast<std::uint8_t>(type[2]), static_cast<std::uint8_t>(type[3])
+    };
+    std::fwrite(header, 1, 8, f);
+    if (len) std::fwrite(data, 1, len, f);
+    std::uint32_t crc = crc32(header + 4, 4);
+    crc = crc32(data, len, crc);
+    std::uint8_t tail[4] = {
+        static_cast<std::uint8_t>(crc >> 24), static_cast<std::uint8_t>(crc >> 16),
+        static_cast<std::uint8_t>(crc >> 8), static_cast<std::uint8_t>(crc)
+    };
+    std::fwrite(tail, 1, 4, f);
+}
+
+const std::uint8_t* rowPtr(const std::uint8_t* rgba, std::size_t stride, int y, int height, bool flipY) {
+    return rgba + stride * static_cast<std::size_t>(flipY ? height - 1 - y : y);
+}
+
+} // namespace
+
+ImageFormat ImageSequenceWriter::formatFromPath(const std::string& path) {
+    auto endsWith = [&](const char* ext) {
+        const std::string e(ext);
+        if (path.size() < e.size()) return false;
+        return std::equal(e.rbegin(), e.rend(), path.rbegin(),
+                          [](char a, char b) { return a == std::tolower(static_cast<unsigned char>(b)); });
+    };
+    if (endsWith(".y4m")) return ImageFormat::Y4M;
+    if (endsWith(".png")) return ImageFormat::PNG;
+    return ImageFormat::Raw;
+}
+
+bool ImageSequenceWriter::open(const std::string& path, ImageFormat fmt, int w, int h, int fps) {
+    close();
+    format = fmt;
+    width = w;
+    height = h;
+    framesWritten = 0;
+
+    if (format == ImageFormat::PNG) {
+        // Parsed here rather than handed to printf, so no user text is a format string
+        namePrefix.clear();
+        nameSuffix.clear();
+        frameDigits = -1;
+        for (std::size_t i = 0; i < path.size(); ++i) {
+            std::string& out = frameDigits < 0 ? namePrefix : nameSuffix;
+            if (path[i] == '%' && i + 1 < path.size() && path[i + 1] == '%') {
+                out += '%';
+                ++i;
+                continue;
+            }
+            if (path[i] == '%' && frameDigits < 0) {
+                std::size_t k = i + 1;
+                int digits = 0;
+                while (k < path.size() && std::isdigit(static_cast<unsigned char>(path[k])) && digits < 100) {
+                    digits = digits * 10 + (path[k++] - '0');
+                }
+                if (k < path.size() && path[k] == 'd') {
+                    frameDigits = std::min(digits, 32);
+                    i = k;
+                    continue;
+                }
+            }
+            out += path[i];
+        }
+        if (frameDigits < 0) {
+            const std::size_t slash = namePrefix.find_last_of("/\\");
+            const std::size_t dot = namePrefix.rfind('.');
+            const std::size_t at = dot == std::string::npos || (slash != std::string::npos && dot < slash)
+                                       ? namePrefix.size() : dot;
+            nameSuffix = namePrefix.substr(at);
+            namePrefix = namePrefix.substr(0, at) + "_";
+            frameDigits = 5;
+        }
+        sequenceOpen = true;
+        return true;
+    }
+
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "ImageSequenceWriter: cannot open " << path << "\n";
+        return false;
+    }
+    if (format == ImageFormat::Y4M) {
+        std::fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, std::max(1, fps));
+    }
+    return true;
+}
+
+bool ImageSequenceWriter::writeFrame(const std::uint8_t* rgba, std::size_t strideBytes, bool flipY) {
+    if (!isOpen()) return false;
+    bool ok = true;
+    switch (format) {
+        case ImageFormat::Raw:
+            for (int y = 0; y < height && ok; ++y) {
+                ok = std::fwrite(rowPtr(rgba, strideBytes, y, height, flipY), 4, width, file) == static_cast<std::size_t>(width);
+            }
+            break;
+        case ImageFormat::Y4M:
+            ok = writeY4mFrame(rgba, strideBytes, flipY);
+            break;
+        case ImageFormat::PNG: {
+            std::string number = std::to_string(framesWritten);
+            if (static_cast<int>(number.size()) < frameDigits) number.insert(0, frameDigits - number.size(), '0');
+            ok = writePng(namePrefix + number + nameSuffix, rgba, strideBytes, flipY);
+            break;
+        }
+    }
+    if (ok) ++framesWritten;
+    return ok;
+}
+
+bool ImageSequenceWriter::writeY4mFrame(const std::uint8_t* rgba, std::size_t strideBytes, bool flipY) {
+    // BT.601 limited-range conversion into three full-resolution planes
+    const std::size_t plane = static_cast<std::size_t>(width) * height;
+    scratch.resize(plane * 3);
+    std::uint8_t* Y = scratch.data();
+    std::uint8_t* U = Y + plane;
+    std::uint8_t* V = U + plane;
+    for (int y = 0; y < height; ++y) {
+        const std::uint8_t* row = rowPtr(rgba, strideBytes, y, height, flipY);
+        for (int x = 0; x < width; ++x) {
+            const int r = row[4 * x], g = row[4 * x + 1], b = row[4 * x + 2];
+            const std::size_t k = static_cast<std::size_t>(y) * width + x;
+            Y[k] = static_cast<std::uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            U[k] = static_cast<std::uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            V[k] = static_cast<std::uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+    std::fputs("FRAME\n", file);
+    return std::fwrite(scratch.data(), 1, scratch.size(), file) == scratch.size();
+}
+
+bool ImageSequenceWriter::writePng(const std::string& path, const std::uint8_t* rgba, std::size_t strideBytes, bool flipY) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        std::cerr << "ImageSequenceWriter: cannot open " << path << "\n";
+        return false;
+    }
+    static const std::uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::fwrite(signature, 1, 8, f);
+
+    std::vector<std::uint8_t> ihdr;
+    putBE32(ihdr, static_cast<std::uint32_t>(width));
+    putBE32(ihdr, static_cast<std::uint32_t>(height));
+    ihdr.insert(ihdr.end(), { 8, 6, 0, 0, 0 }); // 8-bit RGBA, deflate, no filter, no interlace
+    writeChunk(f, "IHDR", ihdr.data(), ihdr.size());
+
+    // Filtered scanlines (filter type 0), wrapped in stored deflate blocks
+    const std::size_t rowBytes = static_cast<std::size_t>(width) * 4 + 1;
+    std::vector<std::uint8_t>& raw = scratch;
+    raw.resize(rowBytes * height);
+    for (int y = 0; y < height; ++y) {
+        raw[y * rowBytes] = 0;
+        std::copy_n(rowPtr(rgba, strideBytes, y, height, flipY), rowBytes - 1, raw.begin() + y * rowBytes + 1);
+    }
+
+    std::vector<std::uint8_t> idat;
+    idat.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    idat.push_back(0x78);
+    idat.push_back(0x01);
+    std::uint32_t a = 1, b = 0;
+    for (std::size_t off = 0; off < raw.size() || off == 0; ) {
+        const std::size_t len = std::min<std::size_t>(65535, raw.size() - off);
+        const bool last = off + len >= raw.size();
+        idat.push_back(last ? 1 : 0);
+        idat.push_back(static_cast<std::uint8_t>(len));
+        idat.push_back(static_cast<std::uint8_t>(len >> 8));
+        idat.push_back(static_cast<std::uint8_t>(~len));
+        idat.push_back(static_cast<std::uint8_t>(~len >> 8));
+        idat.insert(idat.end(), raw.begin() + off, raw.begin() + off + len);
+        for (std::size_t i = off; i < off + len; ++i) {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        off += len;
+        if (last) break;
+    }
+    putBE32(idat, (b << 16) | a);
+    writeChunk(f, "IDAT", idat.data(), idat.size());
+    writeChunk(f, "IEND", nullptr, 0);
+
+    const bool ok = std::ferror(f) == 0;
+    std::fclose(f);
+    return ok;
+}
+
+void ImageSequenceWriter::close() {
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+    sequenceOpen = false;
+}
@@ -0,0 +1,178 @@
+#include "planets/Kernels.hpp"
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define PLANETS_KERNELS_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <immintrin.h>
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace kernels {
+namespace {
+
+std::atomic<const Table*> current{nullptr};
+
+struct CpuFeatures {
+    bool sse4 = false, avx2 = false, avx512 = false;
+};
+
+#ifdef PLANETS_KERNELS_X86
+void cpuid(unsigned leaf, unsigned sub, unsigned r[4]) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(sub));
+    for (int i = 0; i < 4; ++i) r[i] = static_cast<unsigned>(out[i]);
+#else
+    __cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+#endif
+}
+
+// Register state the OS saves on context switch (XCR0); only valid with OSXSAVE
+unsigned long long xcr0() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _xgetbv(0);
+#else
+    unsigned lo = 0, hi = 0;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+}
+#endif
+
+CpuFeatures queryCpu() {
+    CpuFeatures f;
+#ifdef PLANETS_KERNELS_X86
+    unsigned r[4];
+    cpuid(0, 0, r);
+    const unsigned maxLeaf = r[0];
+    if (maxLeaf < 1) return f;
+    cpuid(1, 0, r);
+    const unsigned ecx1 = r[2];
+    f.sse4 = (ecx1 & (1u << 19)) && (ecx1 & (1u << 20)); // SSE4.1, SSE4.2
+
+    // AVX state must be enabled by the OS, not just present in the CPU
+    const bool osxsave = ecx1 & (1u << 27);
+    const bool avx = ecx1 & (1u << 28);
+    const bool fma = ecx1 & (1u << 12);
+    if (!osxsave || !avx || maxLeaf < 7) return f;
+    const unsigned long long xcr = xcr0();
+    const bool ymmState = (xcr & 0x6) == 0x6;          // SSE + AVX
+    const bool zmmState = (xcr & 0xE0) == 0xE0;        // opmask + ZMM0-15 hi + ZMM16-31
+    cpuid(7, 0, r);
+    const unsigned ebx7 = r[1];
+    f.avx2 = ymmState && fma && (ebx7 & (1u << 5));
+    const unsigned avx512Bits = (1u << 16) | (1u << 17) | (1u << 30) | (1u << 31); // F, DQ, BW, VL
+    f.avx512 = f.avx2 && zmmState && (ebx7 & avx512Bits) == avx512Bits;
+#endif
+    return f;
+}
+
+const CpuFeatures& cpu() {
+    static const CpuFeatures features = queryCpu();
+    return features;
+}
+
+const Table* compiled(Isa isa) {
+    switch (isa) {
+    case Isa::Scalar: return detail::scalarTable();
+    case Isa::SSE4:   return detail::sse4Table();
+    case Isa::AVX2:   return detail::avx2Table();
+    case Isa::AVX512: return detail::avx512Table();
+    default:          return nullptr;
+    }
+}
+
+// First use: PLANETS_ISA if set and usable, otherwise the best available
+const Table* initial() {
+    Isa isa = best();
+    if (const char* env = std::getenv("PLANETS_ISA")) {
+        Isa requested;
+        if (!parseIsa(env, requested)) {
+            std::cerr << "Kernels: unknown PLANETS_ISA '" << env << "', using " << isaName(isa) << "\n";
+        } else if (!isSupported(requested)) {
+            std::cerr << "Kernels: " << isaName(requested) << " not available here, using " << isaName(isa) << "\n";
+        } else {
+            isa = requested;
+        }
+    }
+    return table(isa);
+}
+
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+    case Isa::Scalar: return "scalar";
+    case Isa::SSE4:   return "sse4";
+    case Isa::AVX2:   return "avx2";
+    case Isa::AVX512: return "avx512";
+    default:          return "";
+    }
+}
+
+bool parseIsa(const char* name, Isa& out) {
+    for (int i = 0; i < static_cast<int>(Isa::COUNT); ++i) {
+        const Isa isa = static_cast<Isa>(i);
+        const char* candidate = isaName(isa);
+        std::size_t k = 0;
+        while (name[k] && candidate[k] &&
+               std::tolower(static_cast<unsigned char>(name[k])) == candidate[k]) {
+            ++k;
+        }
+        if (!name[k] && !candidate[k]) {
+            out = isa;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isSupported(Isa isa) {
+    if (!compiled(isa)) return false;
+    switch (isa) {
+    case Isa::Scalar: return true;
+    case Isa::SSE4:   return cpu().sse4;
+    case Isa::AVX2:   return cpu().avx2;
+    case Isa::AVX512: return cpu().avx512;
+    default:          return false;
+    }
+}
+
+Isa best() {
+    for (int i = static_cast<int>(Isa::COUNT) - 1; i > 0; --i) {
+        if (isSupported(static_cast<Isa>(i))) return static_cast<Isa>(i);
+    }
+    return Isa::Scalar;
+}
+
+const Table* table(Isa isa) {
+    return isSupported(isa) ? compiled(isa) : nullptr;
+}
+
+bool select(Isa isa) {
+    const Table* t = table(isa);
+    if (!t) return false;
+    current.store(t, std::memory_order_release);
+    return true;
+}
+
+const Table& active() {
+    const Table* t = current.load(std::memory_order_acquire);
+    if (!t) {
+        // Racing first calls resolve to the same table; whichever stores first wins
+        const Table* expected = nullptr;
+        t = initial();
+        if (!current.compare_exchange_strong(expected, t, std::memory_order_acq_rel)) t = expected;
+    }
+    return *t;
+}
+
+}
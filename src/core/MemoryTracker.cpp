@@ -0,0 +1,99 @@
+#include "planets/MemoryTracker.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+bool trackingLinked = false;
+
+struct TagCounters {
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> bytes{0};
+};
+TagCounters tagCounters[MemoryTracker::TAG_COUNT];
+
+// Trivially initialised so they are usable from operator new at any point of a
+// thread's life
+thread_local int currentTag = MemoryTracker::Untagged;
+thread_local std::uint64_t threadCount = 0;
+}
+
+const char* MemoryTracker::tagName(Tag t) {
+    switch (t) {
+    case Bodies:        return "Bodies";
+    case Trails:        return "Trails";
+    case SpatialIndex:  return "Spatial index";
+    case RenderBuffers: return "Render buffers";
+    case IO:            return "I/O";
+    case UI:            return "UI";
+    default:            return "Other";
+    }
+}
+
+bool MemoryTracker::isTracking() {
+    return trackingLinked;
+}
+
+void MemoryTracker::setTracking() {
+    trackingLinked = true;
+}
+
+std::string MemoryTracker::formatBytes(std::size_t bytes) {
+    char text[32];
+    if (bytes < 1024) std::snprintf(text, sizeof(text), "%zu B", bytes);
+    else if (bytes < 1024 * 1024) std::snprintf(text, sizeof(text), "%.1f KB", bytes / 1024.0);
+    else if (bytes < std::size_t(1024) * 1024 * 1024) std::snprintf(text, sizeof(text), "%.1f MB", bytes / (1024.0 * 1024.0));
+    else std::snprintf(text, sizeof(text), "%.2f GB", bytes / (1024.0 * 1024.0 * 1024.0));
+    return text;
+}
+
+std::string MemoryTracker::summary(const Report& report) {
+    std::string out;
+    std::size_t cpuTotal = 0, gpuTotal = 0;
+    for (int t = 0; t < TAG_COUNT; ++t) {
+        const Tag tag = static_cast<Tag>(t);
+        const Traffic traffic = getTraffic(tag);
+        if (report.cpu[t] == 0 && report.gpu[t] == 0 && traffic.allocations == 0) continue;
+        char line[160];
+        std::snprintf(line, sizeof(line), "%-15s cpu %10s  gpu %10s", tagName(tag),
+                      formatBytes(report.cpu[t]).c_str(), formatBytes(report.gpu[t]).c_str());
+        out += line;
+        if (isTracking()) {
+            std::snprintf(line, sizeof(line), "  %llu allocations, %s allocated",
+                          static_cast<unsigned long long>(traffic.allocations), formatBytes(traffic.bytes).c_str());
+            out += line;
+        }
+        out += "\n";
+        cpuTotal += report.cpu[t];
+        gpuTotal += report.gpu[t];
+    }
+    out += "Total           cpu " + formatBytes(cpuTotal) + ", gpu " + formatBytes(gpuTotal) + "\n";
+    return out;
+}
+
+MemoryTracker::Traffic MemoryTracker::getTraffic(Tag t) {
+    Traffic traffic;
+    traffic.allocations = tagCounters[t].allocations.load(std::memory_order_relaxed);
+    traffic.bytes = tagCounters[t].bytes.load(std::memory_order_relaxed);
+    return traffic;
+}
+
+std::uint64_t MemoryTracker::threadAllocations() {
+    return threadCount;
+}
+
+void MemoryTracker::recordAllocation(std::size_t bytes) {
+    TagCounters& c = tagCounters[currentTag];
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    ++threadCount;
+}
+
+MemoryTracker::TagScope::TagScope(Tag t) : previous(static_cast<Tag>(currentTag)) {
+    currentTag = t;
+}
+
+MemoryTracker::TagScope::~TagScope() {
+    currentTag = previous;
+}
@@ -0,0 +1,273 @@
+#include "planets/MetricsServer.hpp"
+#include "planets/FrameTelemetry.hpp"
+#include "planets/Simulation.hpp"
+#include "planets/Tracer.hpp"
+#include <cstdio>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PLANETS_METRICS_POSIX
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+bool MetricsServer::publish(const Simulation& sim, double now) {
+    if (!running) return false;
+    const std::uint64_t stepCount = sim.getStepCount();
+    const std::size_t bodyCount = sim.getPlanets().size();
+    // After a restart the drifts are stale until Diagnostics measures the new run
+    if (stepCount < steps.load(std::memory_order_relaxed) || bodyCount != bodies.load(std::memory_order_relaxed)) {
+        stepsAtRefresh = stepCount;
+        diagnosticsValid.store(false, std::memory_order_relaxed);
+    }
+    steps.store(stepCount, std::memory_order_relaxed);
+    bodies.store(bodyCount, std::memory_order_relaxed);
+    simTime.store(sim.getSimTime(), std::memory_order_relaxed);
+
+    if (lastRefresh >= 0.0 && now - lastRefresh < REFRESH_INTERVAL) return false;
+    if (lastRefresh >= 0.0) {
+        stepRate.store((stepCount - stepsAtRefresh) / (now - lastRefresh), std::memory_order_relaxed);
+    }
+    lastRefresh = now;
+    stepsAtRefresh = stepCount;
+    return true;
+}
+
+void MetricsServer::publishMemory(const MemoryTracker::Report& report) {
+    for (int t = 0; t < MemoryTracker::TAG_COUNT; ++t) {
+        memoryCpu[t].store(report.cpu[t], std::memory_order_relaxed);
+        memoryGpu[t].store(report.gpu[t], std::memory_order_relaxed);
+    }
+}
+
+void MetricsServer::publishFrameTimes(const FrameTelemetry& telemetry) {
+    const FrameTelemetry::Stats s = telemetry.getStats(FrameTelemetry::Frame);
+    frameP50.store(s.p50Ms, std::memory_order_relaxed);
+    frameP95.store(s.p95Ms, std::memory_order_relaxed);
+    frameP99.store(s.p99Ms, std::memory_order_relaxed);
+    frames.store(telemetry.getTotalFrames(), std::memory_order_relaxed);
+    hitches.store(telemetry.getTotalHitches(), std::memory_order_relaxed);
+}
+
+void MetricsServer::publishCaptureQueue(std::size_t writerQueue, int pendingReadbacks) {
+    writerQueueDepth.store(writerQueue, std::memory_order_relaxed);
+    readbacksPending.store(pendingReadbacks, std::memory_order_relaxed);
+}
+
+void MetricsServer::publishDiagnostics(const Diagnostics::Sample& sample) {
+    energy.store(sample.energy, std::memory_order_relaxed);
+    energyError.store(sample.energyDrift, std::memory_order_relaxed);
+    momentumError.store(sample.momentumDrift, std::memory_order_relaxed);
+    angularError.store(sample.angularDrift, std::memory_order_relaxed);
+    virialRatio.store(sample.virialRatio, std::memory_order_relaxed);
+    diagnosticsValid.store(true, std::memory_order_relaxed);
+}
+
+std::string MetricsServer::format() const {
+    std::string out;
+    char line[256];
+    auto metric = [&](const char* name, const char* type, const char* help) {
+        std::snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+        out += line;
+    };
+    auto value = [&](const char* name, double v, const char* labels = "") {
+        std::snprintf(line, sizeof(line), "%s%s %.17g\n", name, labels, v);
+        out += line;
+    };
+    auto load = [](const auto& a) { return static_cast<double>(a.load(std::memory_order_relaxed)); };
+
+    metric("planets_steps_total", "counter", "Physics steps since the bodies were (re)initialised.");
+    value("planets_steps_total", load(steps));
+    metric("planets_step_rate", "gauge", "Physics steps per wall-clock second over the last refresh interval.");
+    value("planets_step_rate", load(stepRate));
+    metric("planets_sim_time_seconds", "gauge", "Simulated time.");
+    value("planets_sim_time_seconds", load(simTime));
+    metric("planets_bodies", "gauge", "Number of bodies.");
+    value("planets_bodies", load(bodies));
+    if (diagnosticsValid.load(std::memory_order_relaxed)) {
+        metric("planets_energy", "gauge", "Total (kinetic + softened potential) energy.");
+        value("planets_energy", load(energy));
+        metric("planets_energy_relative_error", "gauge", "Relative drift of the total energy since the run started.");
+        value("planets_energy_relative_error", load(energyError));
+        metric("planets_momentum_relative_error", "gauge", "Drift of the linear momentum relative to sum m|v|.");
+        value("planets_momentum_relative_error", load(momentumError));
+        metric("planets_angular_momentum_relative_error", "gauge", "Drift of the angular momentum relative to sum m|r x v|.");
+        value("planets_angular_momentum_relative_error", load(angularError));
+        metric("planets_virial_ratio", "gauge", "2K / |U|.");
+        value("planets_virial_ratio", load(virialRatio));
+    }
+
+    metric("planets_frames_total", "counter", "Frames presented.");
+    value("planets_frames_total", load(frames));
+    metric("planets_frame_hitches_total", "counter", "Frames longer than twice the recent median.");
+    value("planets_frame_hitches_total", load(hitches));
+    metric("planets_frame_time_ms", "gauge", "Frame interval percentiles over the recent frames.");
+    value("planets_frame_time_ms", load(frameP50), "{quantile=\"0.5\"}");
+    value("planets_frame_time_ms", load(frameP95), "{quantile=\"0.95\"}");
+    value("planets_frame_time_ms", load(frameP99), "{quantile=\"0.99\"}");
+
+    metric("planets_queue_depth", "gauge", "Items waiting in internal queues.");
+    value("planets_queue_depth", load(writerQueueDepth), "{queue=\"capture_writer\"}");
+    value("planets_queue_depth", load(readbacksPending), "{queue=\"gpu_readback\"}");
+
+    metric("planets_memory_bytes", "gauge", "Bytes held per subsystem.");
+    for (int t = 0; t < MemoryTracker::TAG_COUNT; ++t) {
+        const char* tag = MemoryTracker::tagName(static_cast<MemoryTracker::Tag>(t));
+        char labels[96];
+        std::snprintf(labels, sizeof(labels), "{subsystem=\"%s\",kind=\"cpu\"}", tag);
+        value("planets_memory_bytes", load(memoryCpu[t]), labels);
+        std::snprintf(labels, sizeof(labels), "{subsystem=\"%s\",kind=\"gpu\"}", tag);
+        value("planets_memory_bytes", load(memoryGpu[t]), labels);
+    }
+    if (MemoryTracker::isTracking()) {
+        metric("planets_allocations_total", "counter", "Heap allocations per subsystem.");
+        for (int t = 0; t < MemoryTracker::TAG_COUNT; ++t) {
+            const MemoryTracker::Tag tag = static_cast<MemoryTracker::Tag>(t);
+            char labels[64];
+            std::snprintf(labels, sizeof(labels), "{subsystem=\"%s\"}", MemoryTracker::tagName(tag));
+            value("planets_allocations_total", static_cast<double>(MemoryTracker::getTraffic(tag).allocations), labels);
+        }
+    }
+    return out;
+}
+
+#ifdef PLANETS_METRICS_POSIX
+// Makes way for binding at path: nothing there, or a socket nobody listens on (left
+// behind by a crashed run) is removed. Anything else, a live socket or a regular file
+// given by mistake, is left alone and reported.
+static bool clearSocketPath(const sockaddr_un& addr, std::string& error) {
+    struct stat st;
+    if (::lstat(addr.sun_path, &st) != 0) {
+        if (errno == ENOENT) return true;
+        error = std::string("stat ") + addr.sun_path + ": " + std::strerror(errno);
+        return false;
+    }
+    if (!S_ISSOCK(st.st_mode)) {
+        error = std::string(addr.sun_path) + " exists and is not a socket";
+        return false;
+    }
+    const int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) {
+        error = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+    const bool live = ::connect(probe, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0;
+    const int connectErrno = errno;
+    ::close(probe);
+    if (live) {
+        error = std::string(addr.sun_path) + " is in use by another running instance";
+        return false;
+    }
+    if (connectErrno != ECONNREFUSED) {
+        error = std::string("connect ") + addr.sun_path + ": " + std::strerror(connectErrno);
+        return false;
+    }
+    ::unlink(addr.sun_path);
+    return true;
+}
+
+bool MetricsServer::start(const std::string& socketPath) {
+    stop();
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(addr.sun_path)) {
+        error = "metrics socket path is empty or too long";
+        return false;
+    }
+    std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    if (!clearSocketPath(addr, error)) return false;
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        error = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listenFd, 8) != 0) {
+        error = "bind " + socketPath + ": " + std::strerror(errno);
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    path = socketPath;
+    error.clear();
+    stopping = false;
+    running = true;
+    lastRefresh = -1.0;
+    thread = std::thread([this] { serveLoop(); });
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!running) return;
+    stopping = true;
+    if (thread.joinable()) thread.join();
+    ::close(listenFd);
+    listenFd = -1;
+    ::unlink(path.c_str());
+    running = false;
+}
+
+void MetricsServer::serveLoop() {
+    Tracer::get().setThreadName("Metrics");
+    while (!stopping.load()) {
+        pollfd p{ listenFd, POLLIN, 0 };
+        if (::poll(&p, 1, 200) > 0 && (p.revents & POLLIN)) {
+            const int client = ::accept(listenFd, nullptr, nullptr);
+            if (client >= 0) serveClient(client);
+        }
+    }
+}
+
+void MetricsServer::serveClient(int fd) {
+    // Give the client a moment to send its request; a bare connection gets plain text
+    char request[1024];
+    ssize_t got = 0;
+    pollfd p{ fd, POLLIN, 0 };
+    if (::poll(&p, 1, 100) > 0) got = ::recv(fd, request, sizeof(request), 0);
+    const bool http = got >= 3 && std::strncmp(request, "GET", 3) == 0;
+
+    const std::string body = format();
+    std::string response;
+    if (http) {
+        char header[160];
+        std::snprintf(header, sizeof(header),
+                      "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n\r\n",
+                      body.size());
+        response = header;
+    }
+    response += body;
+
+    // The only server thread must not hang on a client that stops reading, or stop()
+    // would block with it
+    timeval timeout{ 0, SEND_TIMEOUT_MS * 1000 };
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL; // a client that hung up must not kill the process
+#else
+    const int flags = 0;
+#endif
+    std::size_t sent = 0;
+    while (sent < response.size()) {
+        const ssize_t n = ::send(fd, response.data() + sent, response.size() - sent, flags);
+        if (n <= 0 || stopping.load()) break; // timed out, hung up or shutting down
+        sent += static_cast<std::size_t>(n);
+    }
+    ::close(fd);
+}
+#else
+bool MetricsServer::start(const std::string&) {
+    error = "the metrics endpoint needs Unix domain sockets (POSIX)";
+    return false;
+}
+
+void MetricsServer::stop() {}
+void MetricsServer::serveLoop() {}
+void MetricsServer::serveClient(int) {}
+#endif
@@ -0,0 +1,158 @@
+#include "planets/Parallel.hpp"
+#include "planets/Profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+class Pool {
+public:
+    Pool() {
+        const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+        workerCount = hw - 1;
+        threads.reserve(workerCount);
+        for (unsigned i = 0; i < workerCount; ++i) {
+            threads.emplace_back([this, i] {
+                Tracer::get().setThreadName("Worker " + std::to_string(i + 1));
+                workerLoop();
+            });
+        }
+    }
+
+    ~Pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    unsigned chunks() const { return workerCount + 1; }
+
+    void run(std::size_t n, std::size_t minPerChunk, parallel::RangeFn fn, void* ctx) {
+        if (n == 0) return;
+        const std::size_t perChunk = std::max<std::size_t>(1, minPerChunk);
+        const unsigned wanted = static_cast<unsigned>(std::min<std::size_t>(chunks(), (n + perChunk - 1) / perChunk));
+
+        // Small jobs, nested calls and concurrent callers run inline
+        std::unique_lock<std::mutex> jobLock(jobMutex, std::try_to_lock);
+        if (wanted <= 1 || !jobLock.owns_lock()) {
+            fn(ctx, 0, n, 0);
+            return;
+        }
+
+        Job published;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = Job{ fn, ctx, n, wanted, static_cast<std::uint32_t>(++generation) };
+            published = job;
+            remaining.store(wanted, std::memory_order_relaxed);
+            claim.store(static_cast<std::uint64_t>(job.tag) << 32, std::memory_order_release);
+        }
+        wake.notify_all();
+
+        drainChunks(published);
+
+        // Also wait for every worker to leave drainChunks so none can touch the
+        // counters of the next job
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return remaining.load(std::memory_order_acquire) == 0 && active == 0; });
+    }
+
+private:
+    std::vector<std::thread> threads;
+    unsigned workerCount = 0;
+
+    std::mutex jobMutex; // serialises callers
+    std::mutex mutex;    // guards job publication
+    std::condition_variable wake, done;
+    bool stopping = false;
+    unsigned long long generation = 0;
+    unsigned active = 0; // workers currently draining chunks
+
+    // Published under the mutex; workers drain their own copy, so a late wake-up never
+    // mixes the fields of two jobs
+    struct Job {
+        parallel::RangeFn fn = nullptr;
+        void* ctx = nullptr;
+        std::size_t size = 0;
+        unsigned chunks = 0;
+        std::uint32_t tag = 0; // low bits of the generation
+    };
+    Job job;
+    // Job tag in the high half, next unclaimed chunk in the low half. Claims go through
+    // compare-exchange, so one made for an earlier job fails instead of taking a chunk
+    // of the current one (a tag only repeats after 2^32 jobs).
+    std::atomic<std::uint64_t> claim{0};
+    std::atomic<unsigned> remaining{0};
+
+    void drainChunks(const Job& j) {
+        std::uint64_t seen = claim.load(std::memory_order_acquire);
+        for (;;) {
+            if (static_cast<std::uint32_t>(seen >> 32) != j.tag) return;
+            const unsigned c = static_cast<unsigned>(seen & 0xffffffffu);
+            if (c >= j.chunks) return;
+            if (!claim.compare_exchange_weak(seen, seen + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                continue;
+            }
+            const std::size_t begin = j.size * c / j.chunks;
+            const std::size_t end = j.size * (c + 1) / j.chunks;
+            {
+                PLANETS_PROFILE_SCOPE("Chunk");
+                j.fn(j.ctx, begin, end, c);
+            }
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.notify_one();
+            }
+            seen = claim.load(std::memory_order_acquire);
+        }
+    }
+
+    void workerLoop() {
+        unsigned long long seen = 0;
+        for (;;) {
+            Job current;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                current = job; // the job of this generation, even if it has already finished
+                ++active;
+            }
+            drainChunks(current);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --active;
+            }
+            done.notify_one();
+        }
+    }
+};
+
+Pool& pool() {
+    static Pool instance;
+    return instance;
+}
+
+} // namespace
+
+namespace parallel {
+
+unsigned maxChunks() {
+    return pool().chunks();
+}
+
+void detail::run(std::size_t n, std::size_t minPerChunk, RangeFn fn, void* ctx) {
+    pool().run(n, minPerChunk, fn, ctx);
+}
+
+} // namespace parallel
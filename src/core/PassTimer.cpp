@@ -0,0 +1,105 @@
+#include "planets/PassTimer.hpp"
+#include <iostream>
+
+namespace {
+constexpr float SMOOTHING = 0.1f;
+
+inline void smooth(float& avg, float sample) {
+    avg = avg <= 0.0f ? sample : avg + (sample - avg) * SMOOTHING;
+}
+} // namespace
+
+int PassTimer::addPass(const char* name) {
+    if (passCount == MAX_PASSES) {
+        std::cerr << "PassTimer: too many passes, '" << name << "' is not timed\n";
+        return -1;
+    }
+    passes[passCount].name = name;
+    return passCount++;
+}
+
+bool PassTimer::resolve(FrameSlot& slot) {
+    // A frame is published only once all of its queries are done
+    for (int i = 0; i < passCount; ++i) {
+        if (!slot.used[i]) continue;
+        GLint available = 0;
+        glGetQueryObjectiv(slot.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return false;
+    }
+    for (int i = 0; i < passCount; ++i) {
+        if (!slot.used[i]) {
+            // Pass not drawn that frame (e.g. trails off): let the average decay
+            passes[i].lastGpuMs = 0.0f;
+            passes[i].gpuMs -= passes[i].gpuMs * SMOOTHING;
+            continue;
+        }
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &ns);
+        passes[i].lastGpuMs = static_cast<float>(ns) * 1e-6f;
+        smooth(passes[i].gpuMs, passes[i].lastGpuMs);
+        slot.used[i] = false;
+    }
+    slot.pending = false;
+    return true;
+}
+
+bool PassTimer::beginFrame() {
+    // Oldest pending frame first, so results are published in order
+    bool resolved = false;
+    for (int k = 1; k <= FRAME_LATENCY; ++k) {
+        FrameSlot& slot = frames[(current + k) % FRAME_LATENCY];
+        if (!slot.pending) continue;
+        if (!resolve(slot)) break;
+        resolved = true;
+    }
+
+    for (int i = 0; i < passCount; ++i) passes[i].cpuRan = false;
+    current = (current + 1) % FRAME_LATENCY;
+    FrameSlot& slot = frames[current];
+    if (!slot.queries[0]) glGenQueries(MAX_PASSES, slot.queries);
+    recording = !slot.pending;
+    return resolved;
+}
+
+void PassTimer::begin(int pass) {
+    if (pass < 0 || activePass >= 0) return;
+    activePass = pass;
+    passes[pass].cpuStart = std::chrono::steady_clock::now();
+    passes[pass].cpuRan = true;
+    if (recording) glBeginQuery(GL_TIME_ELAPSED, frames[current].queries[pass]);
+}
+
+void PassTimer::end(int pass) {
+    if (pass < 0 || activePass != pass) return;
+    activePass = -1;
+    if (recording) {
+        glEndQuery(GL_TIME_ELAPSED);
+        frames[current].used[pass] = true;
+    }
+    const std::chrono::duration<float, std::milli> cpu = std::chrono::steady_clock::now() - passes[pass].cpuStart;
+    smooth(passes[pass].cpuMs, cpu.count());
+}
+
+void PassTimer::endFrame() {
+    for (int i = 0; i < passCount; ++i) {
+        if (!passes[i].cpuRan) passes[i].cpuMs -= passes[i].cpuMs * SMOOTHING;
+    }
+    if (!recording) return;
+    FrameSlot& slot = frames[current];
+    for (int i = 0; i < passCount; ++i) {
+        if (slot.used[i]) {
+            slot.pending = true;
+            break;
+        }
+    }
+    recording = false;
+}
+
+void PassTimer::destroy() {
+    for (FrameSlot& slot : frames) {
+        if (slot.queries[0]) glDeleteQueries(MAX_PASSES, slot.queries);
+        slot = FrameSlot{};
+    }
+    recording = false;
+    activePass = -1;
+}
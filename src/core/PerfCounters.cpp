@@ -0,0 +1,211 @@
+#include "planets/PerfCounters.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// Set on the thread that enabled the counters; they are per-thread in the kernel
+thread_local bool countingThread = false;
+
+std::uint64_t nowNanos() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+}
+
+PerfCounters& PerfCounters::get() {
+    static PerfCounters instance;
+    return instance;
+}
+
+PerfCounters::~PerfCounters() {
+    close();
+}
+
+const char* PerfCounters::eventName(Event e) {
+    switch (e) {
+    case Cycles:       return "Cycles";
+    case Instructions: return "Instructions";
+    case CacheMisses:  return "LLC misses";
+    case L1dMisses:    return "L1D misses";
+    case BranchMisses: return "Branch misses";
+    default:           return "";
+    }
+}
+
+const char* PerfCounters::regionName(Region r) {
+    switch (r) {
+    case Forces:    return "Forces";
+    case Integrate: return "Integrate";
+    case Benchmark: return "Benchmark";
+    default:        return "";
+    }
+}
+
+bool PerfCounters::setEnabled(bool e) {
+    if (e && !opened && !open()) {
+        enabled = false;
+        return false;
+    }
+    enabled = e;
+    countingThread = e;
+    if (e) reset();
+    return true;
+}
+
+void PerfCounters::reset() {
+    for (int r = 0; r < REGION_COUNT; ++r) {
+        current[r] = window[r] = total[r] = Totals{};
+    }
+    windowStart = -1.0;
+}
+
+#ifdef __linux__
+bool PerfCounters::open() {
+    struct Spec { Event event; std::uint32_t type; std::uint64_t config; };
+    static const Spec specs[EVENT_COUNT] = {
+        { Cycles,       PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { CacheMisses,  PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { L1dMisses,    PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    };
+
+    for (const Spec& s : specs) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = s.type;
+        attr.config = s.config;
+        attr.exclude_kernel = 1; // permitted at perf_event_paranoid <= 2
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = leader < 0 ? 1 : 0; // the leader starts the whole group
+        const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+        if (fd < 0) {
+            if (leader < 0) {
+                error = std::string("perf_event_open: ") + std::strerror(errno);
+                if (errno == EACCES || errno == EPERM) error += " (check kernel.perf_event_paranoid)";
+                else if (errno == ENOENT || errno == EOPNOTSUPP) error += " (no hardware PMU, e.g. in a VM)";
+                return false;
+            }
+            continue; // this PMU lacks the event; count the rest
+        }
+        if (leader < 0) leader = fd;
+        fds[s.event] = fd;
+        index[s.event] = openedCount++;
+    }
+
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    opened = true;
+    error.clear();
+    return true;
+}
+
+void PerfCounters::close() {
+    for (int& fd : fds) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+    for (int& i : index) i = -1;
+    leader = -1;
+    openedCount = 0;
+    opened = false;
+}
+
+bool PerfCounters::read(std::uint64_t* out) const {
+    // Group layout: nr, time_enabled, time_running, values[nr]
+    std::uint64_t buf[3 + EVENT_COUNT];
+    const ssize_t want = static_cast<ssize_t>((3 + openedCount) * sizeof(std::uint64_t));
+    if (::read(leader, buf, sizeof(buf)) < want) return false;
+    // Scale up if the PMU was multiplexed between groups
+    const double scale = buf[2] > 0 ? static_cast<double>(buf[1]) / static_cast<double>(buf[2]) : 1.0;
+    for (int e = 0; e < EVENT_COUNT; ++e) {
+        out[e] = index[e] >= 0 ? static_cast<std::uint64_t>(static_cast<double>(buf[3 + index[e]]) * scale) : 0;
+    }
+    return true;
+}
+#else
+bool PerfCounters::open() {
+    error = "hardware counters need Linux perf_event_open";
+    return false;
+}
+
+void PerfCounters::close() {}
+
+bool PerfCounters::read(std::uint64_t*) const {
+    return false;
+}
+#endif
+
+PerfCounters::Scope::Scope(Region r, std::uint64_t w) : region(r), work(w) {
+    PerfCounters& pc = PerfCounters::get();
+    active = pc.enabled && countingThread && pc.read(start);
+    if (active) start[EVENT_COUNT] = nowNanos();
+}
+
+PerfCounters::Scope::~Scope() {
+    if (!active) return;
+    PerfCounters& pc = PerfCounters::get();
+    std::uint64_t stop[EVENT_COUNT];
+    if (!pc.read(stop)) return;
+    const std::uint64_t elapsed = nowNanos() - start[EVENT_COUNT];
+    Totals& cur = pc.current[region];
+    Totals& all = pc.total[region];
+    for (int e = 0; e < EVENT_COUNT; ++e) {
+        // Scaled counts are estimates and can step backwards slightly
+        const std::uint64_t d = stop[e] > start[e] ? stop[e] - start[e] : 0;
+        cur.values[e] += d;
+        all.values[e] += d;
+    }
+    cur.work += work;
+    all.work += work;
+    cur.nanos += elapsed;
+    all.nanos += elapsed;
+    ++cur.calls;
+    ++all.calls;
+}
+
+void PerfCounters::update(double now, double windowSeconds) {
+    if (!enabled) return;
+    if (windowStart < 0.0) windowStart = now;
+    if (now - windowStart < windowSeconds) return;
+    for (int r = 0; r < REGION_COUNT; ++r) {
+        window[r] = current[r];
+        current[r] = Totals{};
+    }
+    windowStart = now;
+}
+
+std::string PerfCounters::summary(Region r) const {
+    const Totals& t = total[r];
+    const char* unit = r == Forces ? "pair" : r == Integrate ? "body" : "call";
+    if (t.work == 0) return std::string(regionName(r)) + ": no samples";
+
+    const double work = static_cast<double>(t.work);
+    char line[256];
+    int len = std::snprintf(line, sizeof(line), "%s: %.2f IPC, %.1f cycles/%s, %.1f instr/%s",
+                            regionName(r),
+                            t.values[Cycles] ? static_cast<double>(t.values[Instructions]) / t.values[Cycles] : 0.0,
+                            t.values[Cycles] / work, unit, t.values[Instructions] / work, unit);
+    if (isAvailable(L1dMisses) && len < static_cast<int>(sizeof(line))) {
+        len += std::snprintf(line + len, sizeof(line) - len, ", %.3f L1D miss/%s", t.values[L1dMisses] / work, unit);
+    }
+    if (isAvailable(CacheMisses) && len < static_cast<int>(sizeof(line))) {
+        len += std::snprintf(line + len, sizeof(line) - len, ", %.4f LLC miss/%s", t.values[CacheMisses] / work, unit);
+    }
+    if (r == Forces && t.nanos > 0 && len < static_cast<int>(sizeof(line))) {
+        std::snprintf(line + len, sizeof(line) - len, ", %.2f GFLOP/s (est.)", work * PAIR_FLOPS / t.nanos);
+    }
+    return line;
+}
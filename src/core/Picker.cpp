@@ -0,0 +1,78 @@
+#include "planets/Picker.hpp"
+#include "planets/Simulation.hpp"
+#include "planets/Camera.hpp"
+#include <algorithm>
+#include <cmath>
+
+void Picker::setViewport(float left, float top, float width, float height) {
+    vpLeft = left;
+    vpTop = top;
+    vpWidth = std::max(width, 1.0f);
+    vpHeight = std::max(height, 1.0f);
+}
+
+bool Picker::contains(glm::vec2 screen) const {
+    return screen.x >= vpLeft && screen.x < vpLeft + vpWidth &&
+           screen.y >= vpTop && screen.y < vpTop + vpHeight;
+}
+
+glm::vec2 Picker::screenToWorld(const Camera& camera, glm::vec2 screen) const {
+    const float ndcX = (screen.x - vpLeft) / vpWidth * 2.0f - 1.0f;
+    const float ndcY = 1.0f - (screen.y - vpTop) / vpHeight * 2.0f;
+    return camera.getPosition() + glm::vec2(ndcX, ndcY) / camera.getZoom();
+}
+
+int Picker::pickNearest(const Simulation& sim, const Camera& camera, glm::vec2 screen, float tolerancePx) const {
+    const SpatialGrid& grid = sim.getSpatialIndex();
+    if (grid.empty()) return -1;
+
+    // The view has no aspect correction, so x and y have different pixel scales
+    const float zoom = camera.getZoom();
+    const glm::vec2 pxPerWorld(zoom * vpWidth * 0.5f, zoom * vpHeight * 0.5f);
+    // Sprite diameter as in the planet shader (pixel-per-world taken along y)
+    auto spriteRadiusPx = [&](float r) {
+        return 0.5f * std::max(2.5f, std::max(r * spriteScale * 3.0f, 2.0f * r * pxPerWorld.y));
+    };
+
+    const glm::vec2 world = screenToWorld(camera, screen);
+    const float reachPx = tolerancePx + spriteRadiusPx(grid.getMaxRadius());
+    const glm::vec2 reach(reachPx / pxPerWorld.x, reachPx / pxPerWorld.y);
+    candidates.clear();
+    grid.queryRect(world - reach, world + reach, candidates);
+
+    // Closest to the edge of its drawn disc, so a large body under the cursor beats a
+    // small one whose centre happens to be nearer
+    const std::vector<Planet>& planets = sim.getPlanets();
+    int best = -1;
+    float bestScore = tolerancePx;
+    for (std::uint32_t i : candidates) {
+        const Planet& p = planets[i];
+        const float dx = (p.getP().getX() - world.x) * pxPerWorld.x;
+        const float dy = (p.getP().getY() - world.y) * pxPerWorld.y;
+        const float score = std::sqrt(dx * dx + dy * dy) - spriteRadiusPx(p.getRadius());
+        if (score <= bestScore) {
+            bestScore = score;
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+int Picker::pickClosest(const Simulation& sim, const Camera& camera, glm::vec2 screen, float tolerancePx) const {
+    const int hit = pickNearest(sim, camera, screen, tolerancePx);
+    if (hit >= 0) return hit;
+    return sim.getSpatialIndex().nearest(screenToWorld(camera, screen));
+}
+
+void Picker::pickRect(const Simulation& sim, const Camera& camera, glm::vec2 a, glm::vec2 b,
+                      std::vector<std::uint32_t>& out) const {
+    const glm::vec2 wa = screenToWorld(camera, a);
+    const glm::vec2 wb = screenToWorld(camera, b);
+    const glm::vec2 lo(std::min(wa.x, wb.x), std::min(wa.y, wb.y));
+    const glm::vec2 hi(std::max(wa.x, wb.x), std::max(wa.y, wb.y));
+    sim.getSpatialIndex().queryRect(lo, hi, out);
+}
+
+void Picker::pickRadius(const Simulation& sim, glm::vec2 center, float radius, std::vector<std::uint32_t>& out) const {
+    sim.getSpatialIndex().queryRadius(center, radius, out);
+}
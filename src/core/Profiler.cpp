@@ -0,0 +1,88 @@
+#include "planets/Profiler.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// Set on the thread driving beginFrame/endFrame; scopes elsewhere are ignored
+thread_local bool recordingThread = false;
+}
+
+Profiler& Profiler::get() {
+    static Profiler instance;
+    return instance;
+}
+
+Profiler::Profiler() {
+    nodes[0].name = "Frame";
+}
+
+void Profiler::beginFrame() {
+    recordingThread = true;
+    for (int i = 0; i < nodeCount; ++i) {
+        nodes[i].frameTime = {};
+        nodes[i].frameCalls = 0;
+    }
+    current = 0;
+    inFrame = enabled;
+    frameStart = std::chrono::steady_clock::now();
+}
+
+void Profiler::endFrame() {
+    if (!inFrame) return;
+    inFrame = false;
+    nodes[0].frameTime = std::chrono::steady_clock::now() - frameStart;
+    nodes[0].frameCalls = 1;
+    for (int i = 0; i < nodeCount; ++i) {
+        Node& n = nodes[i];
+        n.history[historyHead] = std::chrono::duration<float, std::milli>(n.frameTime).count();
+        n.lastCalls = n.frameCalls;
+    }
+    historyHead = (historyHead + 1) % HISTORY;
+    historyCount = std::min(historyCount + 1, HISTORY);
+}
+
+int Profiler::enter(const char* name) {
+    if (!inFrame || !recordingThread) return -1;
+    // Names are usually the same literal, so the pointer compare nearly always decides
+    Node& parent = nodes[current];
+    int child = parent.firstChild;
+    while (child >= 0 && nodes[child].name != name && std::strcmp(nodes[child].name, name) != 0) {
+        child = nodes[child].nextSibling;
+    }
+    if (child < 0) {
+        if (nodeCount == MAX_NODES) return -1;
+        child = nodeCount++;
+        nodes[child].name = name;
+        nodes[child].parent = current;
+        if (parent.lastChild >= 0) nodes[parent.lastChild].nextSibling = child;
+        else parent.firstChild = child;
+        parent.lastChild = child;
+    }
+    current = child;
+    return child;
+}
+
+void Profiler::leave(int node, std::chrono::steady_clock::duration elapsed) {
+    Node& n = nodes[node];
+    n.frameTime += elapsed;
+    ++n.frameCalls;
+    current = n.parent;
+}
+
+Profiler::Stats Profiler::getStats(int node) const {
+    Stats s;
+    const Node& n = nodes[node];
+    s.calls = n.lastCalls;
+    if (historyCount == 0) return s;
+
+    float sorted[HISTORY];
+    std::copy(n.history, n.history + historyCount, sorted);
+    std::sort(sorted, sorted + historyCount);
+    float sum = 0.0f;
+    for (int i = 0; i < historyCount; ++i) sum += sorted[i];
+    s.lastMs = n.history[(historyHead + HISTORY - 1) % HISTORY];
+    s.minMs = sorted[0];
+    s.avgMs = sum / static_cast<float>(historyCount);
+    s.p99Ms = sorted[std::min(historyCount - 1, (historyCount * 99) / 100)];
+    return s;
+}
@@ -1,37 +1,49 @@
 #include "planets/Renderer.hpp"
+#include "planets/Starfield.hpp"
+#include "planets/Kernels.hpp"
+#include "planets/Profiler.hpp"
 #include <vector>
 #include <algorithm>
-#include <random>
+#include <iostream>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
 
 // ImGui (centralized initialization/shutdown in Renderer)
 #include <imgui.h>
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_opengl3.h>
 
-// Planet shader sources (simple, uniform-colored circular points)
+// Planet shader sources: one instanced quad per body, expanded in screen space so the
+// sprite size is exact at any zoom (no driver point-size clamp)
 static const char* planetVertexShaderSrc = R"(
 #version 330 core
-layout(location = 0) in vec2 aPos;
-layout(location = 1) in float aMass;
-layout(location = 2) in vec3 aVelocity; // unused here, kept for stride compatibility
-layout(location = 3) in vec3 aColor;
-layout(location = 4) in float aRadius;
+layout(location = 0) in vec2 aPos;     // per instance, dynamic stream
+layout(location = 1) in vec4 aColor;   // per instance, static stream, RGBA8 normalized
+layout(location = 2) in float aRadius; // per instance, static stream
+layout(location = 3) in vec2 aCorner;  // per vertex, unit quad corner in [-1,1]
 
 uniform mat4 uView;
+uniform vec2 uViewportPx;     // simulation viewport size in pixels
 uniform float uPixelPerWorld; // pixels per world unit (framebuffer-space)
 uniform float uRadiusScale;   // visual amplification of radius
 
 out vec3 vColor;
+out vec2 vCorner;
 
 void main() {
-    gl_Position = uView * vec4(aPos, 0.0, 1.0);
-
-    // Convert world-space radius to pixels using uPixelPerWorld; ensure a minimum size
+    // Visual diameter in pixels: amplified radius with a minimum size, growing to the
+    // true projected size once the camera is zoomed in far enough
     const float MIN_POINT_SIZE = 2.5;
-    float ps = aRadius * uRadiusScale * 3.0;
-    gl_PointSize = max(MIN_POINT_SIZE, ps);
+    float ps = max(MIN_POINT_SIZE, max(aRadius * uRadiusScale * 3.0, 2.0 * aRadius * uPixelPerWorld));
 
-    vColor = aColor;
+    vec4 center = uView * vec4(aPos, 0.0, 1.0);
+    vec2 offsetNdc = aCorner * ps / max(uViewportPx, vec2(1.0));
+    gl_Position = vec4(center.xy + offsetNdc * center.w, center.zw);
+
+    vColor = aColor.rgb;
+    vCorner = aCorner;
 }
 )";
 
@@ -39,12 +51,14 @@ static const char* planetFragmentShaderSrc = R"(
 #version 330 core
 out vec4 FragColor;
 in vec3 vColor;
+in vec2 vCorner;
 void main() {
     // Use squared distance to avoid an expensive sqrt (length)
-    vec2 d = gl_PointCoord - vec2(0.5);
+    vec2 d = vCorner * 0.5;
     float dist2 = dot(d, d);
     // Smoothstep on squared radii: inner radius ~0.45, outer radius ~0.5
     float alpha = 1.0 - smoothstep(0.45 * 0.45, 0.5 * 0.5, dist2);
+    if (alpha <= 0.0) discard;
     FragColor = vec4(vColor, alpha);
 }
 )";
@@ -54,27 +68,30 @@ static const char* trailVertexShaderSrc = R"(
 #version 330 core
 layout(location = 0) in vec2 aPos;
 layout(location = 1) in float aAge;
+layout(location = 2) in vec4 aColor; // RGBA8 normalized, per trail
 
 out float vAge;
+out vec3 vColor;
 
 uniform mat4 uView;
 void main() {
     gl_Position = uView * vec4(aPos, 0.0, 1.0);
     vAge = aAge;
+    vColor = aColor.rgb;
 }
 )";
 
 static const char* trailFragmentShaderSrc = R"(
 #version 330 core
 in float vAge;
+in vec3 vColor;
 out vec4 FragColor;
 
-uniform vec3 uColor;
 void main() {
     // Linear fade based on normalized age. Clamp to avoid numerical issues.
     float a = clamp(1.0 - vAge, 0.0, 1.0);
     float alpha = a * 0.6;
-    FragColor = vec4(uColor, alpha);
+    FragColor = vec4(vColor, alpha);
 }
 )";
 
@@ -138,6 +155,37 @@ void main() {
 }
 )";
 
+// Density LOD shader: shares the background's fullscreen-quad vertex shader and
+// tone-maps the per-cell body counts; sparse cells are left to the sprite pass
+static const char* densityFragmentShaderSrc = R"(
+#version 330 core
+in vec2 vNdcRaw;
+out vec4 FragColor;
+
+uniform sampler2D uDensity;
+uniform vec2 uGridScale; // viewport / grid extent (grid cells may overhang the viewport)
+uniform float uLogMax;   // log(1 + max count)
+uniform float uSparse;   // cells at or below this count are drawn as sprites
+
+vec3 heat(float t) {
+    vec3 c0 = vec3(0.10, 0.02, 0.25);
+    vec3 c1 = vec3(0.85, 0.25, 0.20);
+    vec3 c2 = vec3(1.00, 0.85, 0.40);
+    vec3 c3 = vec3(1.00, 1.00, 0.95);
+    if (t < 0.4) return mix(c0, c1, t / 0.4);
+    if (t < 0.8) return mix(c1, c2, (t - 0.4) / 0.4);
+    return mix(c2, c3, (t - 0.8) / 0.2);
+}
+
+void main() {
+    vec2 uv = (vNdcRaw * 0.5 + 0.5) * uGridScale;
+    float count = texture(uDensity, uv).r;
+    if (count <= uSparse) discard;
+    float t = clamp(log(1.0 + count) / max(uLogMax, 1e-4), 0.0, 1.0);
+    FragColor = vec4(heat(t), 0.35 + 0.65 * t);
+}
+)";
+
 // Static starfield shader sources (NDC points, not camera-transformed)
 static const char* starVertexShaderSrc = R"(
 #version 330 core
@@ -164,56 +212,55 @@ void main() {
 }
 )";
 
-// Helper: compile shader and print errors
-static GLuint compileShader(GLenum type, const char* src) {
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &src, nullptr);
-    glCompileShader(shader);
-
-    GLint success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        // Shader compilation failed - silently continue
-    }
-    return shader;
-}
-
-// Helper: link program and print errors
-static GLuint linkProgram(GLuint vs, GLuint fs) {
-    GLuint prog = glCreateProgram();
-    glAttachShader(prog, vs);
-    glAttachShader(prog, fs);
-    glLinkProgram(prog);
-
-    GLint success;
-    glGetProgramiv(prog, GL_LINK_STATUS, &success);
-    if (!success) {
-        // Program linking failed - silently continue
-    }
-    return prog;
-}
-
 Renderer::Renderer(int w, int h, const char* title)
         : width(w), height(h), window(nullptr), 
-            planetVAO(0), planetVBO(0), planetShaderProgram(0),
-            trailVAO(0), trailVBO(0), trailShaderProgram(0),
+            planetVAO(0), planetStaticVBO(0), planetShaderProgram(0),
+            trailVAO(0), trailShaderProgram(0),
             backgroundVAO(0), backgroundVBO(0), backgroundShaderProgram(0),
             cameraPosition(0.0f, 0.0f), cameraZoom(1.0f),
-            trailsEnabled(true), maxTrailLength(500),
+            trailsEnabled(true),
             starfieldEnabled(true) {
 }
 
 bool Renderer::init() {
+    if (headless) {
+        // Prefer the windowless null platform with an OSMesa (llvmpipe) context;
+        // fall back to an invisible native window if that is unavailable.
+        if (glfwPlatformSupported(GLFW_PLATFORM_NULL)) {
+            glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+        }
+    }
     if (!glfwInit()) {
-        return false;
+        if (!headless) return false;
+        glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+        if (!glfwInit()) return false;
     }
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (headless) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        if (glfwGetPlatform() == GLFW_PLATFORM_NULL) {
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+        }
+    }
 
     window = glfwCreateWindow(width, height, "Planetary Simulation", nullptr, nullptr);
+    if (!window && headless && glfwGetPlatform() == GLFW_PLATFORM_NULL) {
+        // No OSMesa: retry on the native platform with a hidden window
+        glfwTerminate();
+        glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+        if (glfwInit()) {
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+            glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            window = glfwCreateWindow(width, height, "Planetary Simulation", nullptr, nullptr);
+        }
+    }
     if (!window) {
+        std::cerr << "Renderer: failed to create " << (headless ? "offscreen " : "") << "GL context\n";
         glfwTerminate();
         return false;
     }
@@ -224,8 +271,20 @@ bool Renderer::init() {
         return false;
     }
 
-    // Initialize ImGui AFTER the GL context is current
-    if (!imguiInitialized) {
+    // Event callbacks for render-on-demand; ImGui installs its own afterwards and
+    // chains to these, so UI input also counts as an event
+    glfwSetWindowUserPointer(window, this);
+    glfwSetCursorPosCallback(window, [](GLFWwindow* w, double, double) { onWindowEvent(w); });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow* w, int, int, int) { onWindowEvent(w); });
+    glfwSetScrollCallback(window, [](GLFWwindow* w, double, double) { onWindowEvent(w); });
+    glfwSetKeyCallback(window, [](GLFWwindow* w, int, int, int, int) { onWindowEvent(w); });
+    glfwSetCharCallback(window, [](GLFWwindow* w, unsigned int) { onWindowEvent(w); });
+    glfwSetWindowFocusCallback(window, [](GLFWwindow* w, int) { onWindowEvent(w); });
+    glfwSetFramebufferSizeCallback(window, [](GLFWwindow* w, int, int) { onWindowEvent(w); });
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow* w) { onWindowEvent(w); });
+
+    // Initialize ImGui AFTER the GL context is current (no UI when headless)
+    if (!imguiInitialized && !headless) {
         IMGUI_CHECKVERSION();
         ImGui::CreateContext();
         ImGuiIO& io = ImGui::GetIO();
@@ -243,74 +302,97 @@ bool Renderer::init() {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     
-    // Enable point size control
+    // Enable point size control (starfield points)
     glEnable(GL_PROGRAM_POINT_SIZE);
 
-    // Compile and link planet shaders
-    GLuint planetVS = compileShader(GL_VERTEX_SHADER, planetVertexShaderSrc);
-    GLuint planetFS = compileShader(GL_FRAGMENT_SHADER, planetFragmentShaderSrc);
-    planetShaderProgram = linkProgram(planetVS, planetFS);
-    glDeleteShader(planetVS);
-    glDeleteShader(planetFS);
+    // Build shader programs (cached driver binaries when available)
+    planetShaderProgram = shaderCache.getProgram("planet",
+        { "planet.vert", planetVertexShaderSrc }, { "planet.frag", planetFragmentShaderSrc });
+    trailShaderProgram = shaderCache.getProgram("trail",
+        { "trail.vert", trailVertexShaderSrc }, { "trail.frag", trailFragmentShaderSrc });
+    backgroundShaderProgram = shaderCache.getProgram("background",
+        { "background.vert", backgroundVertexShaderSrc }, { "background.frag", backgroundFragmentShaderSrc });
+    // Density LOD program reuses the fullscreen-quad vertex shader
+    densityShaderProgram = shaderCache.getProgram("density",
+        { "background.vert", backgroundVertexShaderSrc }, { "density.frag", densityFragmentShaderSrc });
+    if (!planetShaderProgram || !trailShaderProgram || !backgroundShaderProgram || !densityShaderProgram) {
+        std::cerr << "Renderer: shader programs unavailable\n";
+        return false;
+    }
+
+    passStarfield = passTimer.addPass("Starfield");
+    passTrails = passTimer.addPass("Trails");
+    passPlanets = passTimer.addPass("Planets");
+    passUpscale = passTimer.addPass("Upscale");
 
     // Get planet shader uniform locations
     loc_uView = glGetUniformLocation(planetShaderProgram, "uView");
     loc_uPixelPerWorld = glGetUniformLocation(planetShaderProgram, "uPixelPerWorld");
     loc_uRadiusScale = glGetUniformLocation(planetShaderProgram, "uRadiusScale");
-
-    // Compile and link trail shaders
-    GLuint trailVS = compileShader(GL_VERTEX_SHADER, trailVertexShaderSrc);
-    GLuint trailFS = compileShader(GL_FRAGMENT_SHADER, trailFragmentShaderSrc);
-    trailShaderProgram = linkProgram(trailVS, trailFS);
-    glDeleteShader(trailVS);
-    glDeleteShader(trailFS);
+    loc_uViewportPx = glGetUniformLocation(planetShaderProgram, "uViewportPx");
 
     // Get trail shader uniform locations
     trailLoc_uView = glGetUniformLocation(trailShaderProgram, "uView");
-    trailLoc_uColor = glGetUniformLocation(trailShaderProgram, "uColor");
 
-    // Compile and link background shaders
-    GLuint backgroundVS = compileShader(GL_VERTEX_SHADER, backgroundVertexShaderSrc);
-    GLuint backgroundFS = compileShader(GL_FRAGMENT_SHADER, backgroundFragmentShaderSrc);
-    backgroundShaderProgram = linkProgram(backgroundVS, backgroundFS);
-    glDeleteShader(backgroundVS);
-    glDeleteShader(backgroundFS);
+    densityLoc_uGridScale = glGetUniformLocation(densityShaderProgram, "uGridScale");
+    densityLoc_uLogMax = glGetUniformLocation(densityShaderProgram, "uLogMax");
+    densityLoc_uSparse = glGetUniformLocation(densityShaderProgram, "uSparse");
+    glUseProgram(densityShaderProgram);
+    glUniform1i(glGetUniformLocation(densityShaderProgram, "uDensity"), 0);
+    glUseProgram(0);
 
-    // Create planet VAO and VBO
+    // Create planet VAO: a shared unit quad plus two per-instance streams, static
+    // colour/radius (8 bytes) and streamed positions (8 bytes) = 16 bytes per body
     glGenVertexArrays(1, &planetVAO);
-    glGenBuffers(1, &planetVBO);
+    glGenBuffers(1, &planetQuadVBO);
+    glGenBuffers(1, &planetStaticVBO);
 
     glBindVertexArray(planetVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, planetVBO);
-    glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
 
-    // Planet vertex attributes: position (vec2), mass (float), velocity (vec3), color (vec3), radius (float)
-    // Layout: pos(2), mass(1), vel(3), color(3), radius(1) = 10 floats
-    GLsizei pstride = 10 * sizeof(float);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, pstride, (void*)0);
+    const float quadCorners[] = {
+        -1.0f, -1.0f,
+         1.0f, -1.0f,
+        -1.0f,  1.0f,
+         1.0f,  1.0f
+    };
+    glBindBuffer(GL_ARRAY_BUFFER, planetQuadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadCorners), quadCorners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, planetStaticVBO);
+    glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+
+    // Static layout: color (RGBA8), radius (float) = 8 bytes
+    GLsizei sstride = sizeof(PlanetStatic);
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, pstride, (void*)(2 * sizeof(float)));
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sstride, (void*)offsetof(PlanetStatic, color));
+    glVertexAttribDivisor(1, 1);
     glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, pstride, (void*)(3 * sizeof(float)));
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sstride, (void*)offsetof(PlanetStatic, radius));
+    glVertexAttribDivisor(2, 1);
+    // Position attribute (location 0) is pointed at the current ring region per upload
+    glEnableVertexAttribArray(0);
+    glVertexAttribDivisor(0, 1);
+
+    // Subset VAO: same quad, interleaved 16-byte instances bound per write
+    glGenVertexArrays(1, &planetSubsetVAO);
+    glBindVertexArray(planetSubsetVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, planetQuadVBO);
     glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, pstride, (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(4);
-    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, pstride, (void*)(9 * sizeof(float)));
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    for (GLuint loc = 0; loc < 3; ++loc) {
+        glEnableVertexAttribArray(loc);
+        glVertexAttribDivisor(loc, 1);
+    }
 
-    // Create trail VAO and VBO
+    // Create trail VAO; vertices stream through trailStream and are bound per write
+    // Trail vertex attributes: position (vec2), age (float), color (RGBA8) = 16 bytes
     glGenVertexArrays(1, &trailVAO);
-    glGenBuffers(1, &trailVBO);
-
     glBindVertexArray(trailVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, trailVBO);
-    glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
-
-    // Trail vertex attributes: position (vec2), age (float)
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(2);
 
     // Create background VAO and VBO
     glGenVertexArrays(1, &backgroundVAO);
@@ -339,6 +421,13 @@ bool Renderer::init() {
     updateViewMatrix();
     initStarfield();
 
+    // Headless rendering targets an FBO of the requested size; captures stay at full
+    // resolution regardless of frame time
+    if (headless) {
+        if (!offscreen.resize(width, height)) return false;
+        dynamicResolution.setEnabled(false);
+    }
+
     return true;
 }
 
@@ -360,52 +449,81 @@ void Renderer::pan(float dx, float dy) {
 }
 
 void Renderer::beginFrame() {
+    if (passTimer.beginFrame()) {
+        // Resolution scaling reacts to the GPU cost of the scene passes only
+        dynamicResolution.update(passTimer.getLastGpuMs(passStarfield) + passTimer.getLastGpuMs(passTrails) +
+                                 passTimer.getLastGpuMs(passPlanets) + passTimer.getLastGpuMs(passUpscale));
+    }
+    if (headless) offscreen.bind();
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 }
 
+void Renderer::beginScene() {
+    int fbW = 0, fbH = 0; glfwGetFramebufferSize(window, &fbW, &fbH);
+    const int viewW = vpWidth > 0 ? vpWidth : fbW;
+    const int viewH = vpHeight > 0 ? vpHeight : fbH;
+
+    const float scale = dynamicResolution.getScale();
+    sceneScaled = scale < 1.0f && viewW > 0 && viewH > 0 &&
+        sceneTarget.resize(std::max(1, static_cast<int>(std::lround(viewW * scale))),
+                           std::max(1, static_cast<int>(std::lround(viewH * scale))));
+    if (sceneScaled) {
+        // Sprite sizes and culling keep using the native viewport (vpWidth/vpHeight),
+        // so the scene looks the same once upscaled
+        sceneTarget.bind();
+        glViewport(0, 0, sceneTarget.getWidth(), sceneTarget.getHeight());
+        glClear(GL_COLOR_BUFFER_BIT);
+    } else {
+        glViewport(vpLeft, vpBottom, viewW, viewH);
+    }
+}
+
+void Renderer::endScene() {
+    int fbW = 0, fbH = 0; glfwGetFramebufferSize(window, &fbW, &fbH);
+    if (headless) {
+        fbW = width;
+        fbH = height;
+    }
+    const GLuint output = getSceneFramebuffer();
+    if (sceneScaled) {
+        PassTimer::Scope timed(passTimer, passUpscale);
+        const int viewW = vpWidth > 0 ? vpWidth : fbW;
+        const int viewH = vpHeight > 0 ? vpHeight : fbH;
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneTarget.getFramebuffer());
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, output);
+        glBlitFramebuffer(0, 0, sceneTarget.getWidth(), sceneTarget.getHeight(),
+                          vpLeft, vpBottom, vpLeft + viewW, vpBottom + viewH,
+                          GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, output);
+        sceneScaled = false;
+    }
+    glViewport(0, 0, fbW, fbH);
+}
+
+void Renderer::readScenePixels(std::vector<std::uint8_t>& out) const {
+    int fbW = width, fbH = height;
+    if (!headless) glfwGetFramebufferSize(window, &fbW, &fbH);
+    out.resize(static_cast<std::size_t>(fbW) * fbH * 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, getSceneFramebuffer());
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, fbW, fbH, GL_RGBA, GL_UNSIGNED_BYTE, out.data());
+}
+
 void Renderer::drawBackground(const Camera& camera) {
     if (!starfieldEnabled) {
         return;
     }
     (void)camera;
+    PassTimer::Scope timed(passTimer, passStarfield);
     drawStarfield();
 }
 
 void Renderer::initStarfield() {
-    starCount = 4000;
-    std::vector<float> data;
-    data.reserve(starCount * 5);
-
-    std::mt19937 rng(12345);
-    std::uniform_real_distribution<float> dpos(-1.0f, 1.0f);
-    std::uniform_real_distribution<float> dcol(0.75f, 1.0f);
-    std::uniform_int_distribution<int> huePick(0, 2);
-
-    for (int i = 0; i < starCount; ++i) {
-        float x = dpos(rng);
-        float y = dpos(rng);
-        int hue = huePick(rng);
-        float r = dcol(rng), g = dcol(rng), b = dcol(rng);
-
-        switch (hue) {
-            case 0: // pale blue
-                r *= 0.85f; g *= 0.92f; b *= 1.00f;
-                break;
-            case 1: // pale yellow
-                r *= 1.00f; g *= 0.95f; b *= 0.85f;
-                break;
-            case 2: // neutral white
-                r *= 0.95f; g *= 0.98f; b *= 1.00f;
-            break;
-        }
-
-        data.push_back(x);
-        data.push_back(y);
-        data.push_back(r);
-        data.push_back(g);
-        data.push_back(b);
-    }
+    const std::vector<Star> stars = generateStarfield();
+    starCount = static_cast<int>(stars.size());
+    static_assert(sizeof(Star) == 5 * sizeof(float), "Star must be tightly packed");
 
     // Create VAO/VBO for stars
     glGenVertexArrays(1, &starVAO);
@@ -413,19 +531,16 @@ void Renderer::initStarfield() {
 
     glBindVertexArray(starVAO);
     glBindBuffer(GL_ARRAY_BUFFER, starVBO);
-    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), data.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, stars.size() * sizeof(Star), stars.data(), GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float)));
     glBindVertexArray(0);
 
-    // Compile starfield shader program
-    GLuint vs = compileShader(GL_VERTEX_SHADER, starVertexShaderSrc);
-    GLuint fs = compileShader(GL_FRAGMENT_SHADER, starFragmentShaderSrc);
-    starShaderProgram = linkProgram(vs, fs);
-    glDeleteShader(vs);
-    glDeleteShader(fs);
+    // Starfield shader program (drawStarfield skips drawing if it failed)
+    starShaderProgram = shaderCache.getProgram("star",
+        { "star.vert", starVertexShaderSrc }, { "star.frag", starFragmentShaderSrc });
 }
 
 void Renderer::drawStarfield() {
@@ -440,98 +555,341 @@ void Renderer::drawStarfield() {
     glUseProgram(0);
 }
 
-void Renderer::drawPlanets(const std::vector<Planet>& planets, const Camera& camera) {
-    if (planets.empty()) return;
+static std::uint32_t packColor(const glm::vec3& c) {
+    auto q = [](float v) { return static_cast<std::uint32_t>(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f); };
+    return q(c.r) | (q(c.g) << 8) | (q(c.b) << 16) | (255u << 24);
+}
 
-    // Reusable buffer to reduce allocations
-    static thread_local std::vector<float> planetData;
-    planetData.clear();
-    planetData.reserve(planets.size() * 10);  // 10 values per planet (2 position, 1 mass, 3 velocity, 3 color, 1 radius)
-
-    for (const auto& planet : planets) {
-        planetData.push_back(planet.getP().getX());
-        planetData.push_back(planet.getP().getY());
-        planetData.push_back(planet.getMass());
-        planetData.push_back(planet.getV().getX());
-        planetData.push_back(planet.getV().getY());
-        planetData.push_back(0.0f); // Z component (unused in 2D)
-        const glm::vec3 c = planet.getColor();
-        planetData.push_back(c.r);
-        planetData.push_back(c.g);
-        planetData.push_back(c.b);
-        planetData.push_back(planet.getRadius());
-    }
-
-    // Upload planet data to GPU
-    glBindBuffer(GL_ARRAY_BUFFER, planetVBO);
-    glBufferData(GL_ARRAY_BUFFER, planetData.size() * sizeof(float), planetData.data(), GL_DYNAMIC_DRAW);
+void Renderer::uploadPlanetStatics(const std::vector<Planet>& planets) {
+    planetStatics.resize(planets.size());
+    for (size_t i = 0; i < planets.size(); ++i) {
+        planetStatics[i].color = packColor(planets[i].getColor());
+        planetStatics[i].radius = planets[i].getRadius();
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, planetStaticVBO);
+    glBufferData(GL_ARRAY_BUFFER, planetStatics.size() * sizeof(PlanetStatic), planetStatics.data(), GL_STATIC_DRAW);
+}
+
+bool Renderer::uploadPlanetPositions(const PhysicsEngine& physics) {
+    PLANETS_PROFILE_SCOPE("Pack");
+    const size_t count = physics.getBodyCount();
+    const size_t bytes = count * 2 * sizeof(float);
+    if (bytes > planetPositions.regionSize()) {
+        // Grow geometrically so body-count changes rarely recreate the ring
+        size_t capacity = 1024;
+        while (capacity < count) capacity *= 2;
+        if (!planetPositions.create(GL_ARRAY_BUFFER, capacity * 2 * sizeof(float))) return false;
+    }
+
+    float* dst = static_cast<float*>(planetPositions.beginWrite(bytes));
+    if (!dst) return false;
+    // Interleaved straight from the physics engine's position arrays
+    kernels::active().packPositions(physics.getPositionsX(), physics.getPositionsY(), count, dst);
+    planetPositions.endWrite();
 
+    glBindBuffer(GL_ARRAY_BUFFER, planetPositions.id());
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)planetPositions.currentOffset());
+    return true;
+}
+
+void Renderer::setPlanetUniforms(const Camera& camera) {
     glUseProgram(planetShaderProgram);
     glm::mat4 viewMatrix = camera.getViewMatrix();
     glUniformMatrix4fv(loc_uView, 1, GL_FALSE, glm::value_ptr(viewMatrix));
     
     int fbW = 0, fbH = 0; glfwGetFramebufferSize(window, &fbW, &fbH);
-    float pixelPerWorld = camera.getZoom() * static_cast<float>(fbH);
+    const float viewW = static_cast<float>(vpWidth > 0 ? vpWidth : fbW);
+    const float viewH = static_cast<float>(vpHeight > 0 ? vpHeight : fbH);
+    // The view maps world units to NDC by zoom; NDC spans viewH/2 pixels per unit
+    float pixelPerWorld = camera.getZoom() * viewH * 0.5f;
     if (loc_uPixelPerWorld >= 0) glUniform1f(loc_uPixelPerWorld, pixelPerWorld);
     if (loc_uRadiusScale   >= 0) glUniform1f(loc_uRadiusScale, planetRadiusScale);
+    if (loc_uViewportPx    >= 0) glUniform2f(loc_uViewportPx, viewW, viewH);
+}
+
+void Renderer::drawPlanets(const Simulation& sim, const Camera& camera) {
+    const std::vector<Planet>& planets = sim.getPlanets();
+    if (planets.empty()) return;
+    PassTimer::Scope timed(passTimer, passPlanets);
+    PLANETS_PROFILE_SCOPE("Planets");
+    MemoryTracker::TagScope tag(MemoryTracker::RenderBuffers);
+
+    const bool useDensity = planetRenderMode == PlanetRenderMode::Density ||
+        (planetRenderMode == PlanetRenderMode::Auto && planets.size() >= densityAutoThreshold);
+    if (useDensity) {
+        drawDensity(planets, camera);
+        return;
+    }
+
+    // Cull against the view using the simulation's spatial index. The margin covers
+    // the largest sprite so bodies just off screen still contribute their edge.
+    const SpatialGrid& index = sim.getSpatialIndex();
+    glm::vec2 viewLo, viewHi;
+    camera.getVisibleRect(viewLo, viewHi);
+    {
+        int fbW = 0, fbH = 0; glfwGetFramebufferSize(window, &fbW, &fbH);
+        const float viewW = static_cast<float>(vpWidth > 0 ? vpWidth : fbW);
+        const float viewH = static_cast<float>(vpHeight > 0 ? vpHeight : fbH);
+        const float pxPerWorld = std::max(camera.getZoom() * 0.5f * std::min(viewW, viewH), 1e-6f);
+        const float maxR = index.getMaxRadius();
+        const float halfPx = 0.5f * std::max(2.5f, maxR * planetRadiusScale * 3.0f);
+        const glm::vec2 margin(halfPx / pxPerWorld + maxR);
+        viewLo -= margin;
+        viewHi += margin;
+    }
+    const bool allVisible = viewLo.x <= index.getMin().x && viewLo.y <= index.getMin().y &&
+                            viewHi.x >= index.getMax().x && viewHi.y >= index.getMax().y;
+    if (!allVisible) {
+        // Pack and upload only what is on screen, and only when the bodies or the view moved
+        const bool subsetCurrent = subsetUploaded && subsetBodyCount == planets.size() &&
+                                   subsetStateVersion == sim.getStateVersion() &&
+                                   subsetStaticVersion == sim.getStaticVersion() &&
+                                   subsetViewLo == viewLo && subsetViewHi == viewHi;
+        if (!subsetCurrent) {
+            visibleBodies.clear();
+            index.queryRect(viewLo, viewHi, visibleBodies);
+            subsetUploaded = uploadPlanetSubset(planets, visibleBodies);
+            if (!subsetUploaded) return;
+            subsetStateVersion = sim.getStateVersion();
+            subsetStaticVersion = sim.getStaticVersion();
+            subsetViewLo = viewLo;
+            subsetViewHi = viewHi;
+            subsetBodyCount = planets.size();
+        }
+        drawPlanetSubset(camera);
+        return;
+    }
 
     glBindVertexArray(planetVAO);
-    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(planets.size()));
+
+    // Colour and radius change only on (re)initialisation; positions change per step.
+    // When neither version moved (e.g. paused) the last uploaded region is redrawn as is.
+    const bool countChanged = planets.size() != uploadedPlanetCount;
+    if (countChanged || sim.getStaticVersion() != uploadedStaticVersion) {
+        uploadPlanetStatics(planets);
+        uploadedStaticVersion = sim.getStaticVersion();
+    }
+    if (countChanged || sim.getStateVersion() != uploadedStateVersion) {
+        if (!uploadPlanetPositions(sim.getPhysics())) {
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            uploadedPlanetCount = 0;
+            return;
+        }
+        uploadedStateVersion = sim.getStateVersion();
+        uploadedPlanetCount = planets.size();
+    }
+
+    PLANETS_PROFILE_SCOPE("Submit");
+    setPlanetUniforms(camera);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(uploadedPlanetCount));
+    planetPositions.fence();
 
     glBindVertexArray(0);
     glUseProgram(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-
-void Renderer::updateTrails(const std::vector<Planet>& planets) {
-    if (trails.size() != planets.size()) {
-        trails.clear();
-        trails.resize(planets.size());
+bool Renderer::uploadPlanetSubset(const std::vector<Planet>& planets, const std::vector<std::uint32_t>& indices) {
+    PLANETS_PROFILE_SCOPE("Pack");
+    subsetInstanceCount = 0;
+    if (indices.empty()) return true;
+    const size_t bytes = indices.size() * sizeof(PlanetInstance);
+    if (bytes > planetInstances.regionSize()) {
+        size_t capacity = 1024;
+        while (capacity < indices.size()) capacity *= 2;
+        if (!planetInstances.create(GL_ARRAY_BUFFER, capacity * sizeof(PlanetInstance))) return false;
     }
-
-    for (size_t i = 0; i < planets.size(); ++i) {
-        trails[i].push_back(planets[i].getP());
-        while (trails[i].size() > maxTrailLength) {
-            trails[i].pop_front();
-        }
+    PlanetInstance* dst = static_cast<PlanetInstance*>(planetInstances.beginWrite(bytes));
+    if (!dst) return false;
+    for (std::uint32_t idx : indices) {
+        const Planet& planet = planets[idx];
+        dst->x = planet.getP().getX();
+        dst->y = planet.getP().getY();
+        dst->color = packColor(planet.getColor());
+        dst->radius = planet.getRadius();
+        ++dst;
     }
+    planetInstances.endWrite();
+    subsetInstanceCount = indices.size();
+    return true;
 }
 
-void Renderer::drawTrails(const std::vector<Planet>& planets, const Camera& camera) {
-    if (!trailsEnabled || planets.empty()) return;
+void Renderer::drawPlanetSubset(const Camera& camera) {
+    if (subsetInstanceCount == 0) return;
 
-    updateTrails(planets);
+    PLANETS_PROFILE_SCOPE("Submit");
+    glBindVertexArray(planetSubsetVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, planetInstances.id());
+    const size_t base = planetInstances.currentOffset();
+    const GLsizei stride = sizeof(PlanetInstance);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(PlanetInstance, x)));
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(base + offsetof(PlanetInstance, color)));
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(PlanetInstance, radius)));
 
-    glUseProgram(trailShaderProgram);
-    glm::mat4 viewMatrix = camera.getViewMatrix();
-    glUniformMatrix4fv(trailLoc_uView, 1, GL_FALSE, glm::value_ptr(viewMatrix));
+    setPlanetUniforms(camera);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(subsetInstanceCount));
+    planetInstances.fence();
 
-    // Reusable buffer to reduce allocations
-    static thread_local std::vector<float> trailData;
+    glBindVertexArray(0);
+    glUseProgram(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-    for (size_t i = 0; i < trails.size() && i < planets.size(); ++i) {
-        if (trails[i].size() < 2) continue;
+void Renderer::drawDensity(const std::vector<Planet>& planets, const Camera& camera) {
+    int fbW = 0, fbH = 0; glfwGetFramebufferSize(window, &fbW, &fbH);
+    const int viewW = vpWidth > 0 ? vpWidth : fbW;
+    const int viewH = vpHeight > 0 ? vpHeight : fbH;
+    if (viewW <= 0 || viewH <= 0) return;
 
-        trailData.clear();
-        trailData.reserve(trails[i].size() * 3);
+    {
+        PLANETS_PROFILE_SCOPE("Density bin");
+        densityGrid.build(planets, camera.getPosition(), camera.getZoom(), viewW, viewH);
+    }
+    const int cols = densityGrid.getCols();
+    const int rows = densityGrid.getRows();
+
+    if (!densityTexture) {
+        glGenTextures(1, &densityTexture);
+        glBindTexture(GL_TEXTURE_2D, densityTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, densityTexture);
+    if (cols != densityTexCols || rows != densityTexRows) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, cols, rows, 0, GL_RED, GL_FLOAT, densityGrid.getDensity().data());
+        densityTexCols = cols;
+        densityTexRows = rows;
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, cols, rows, GL_RED, GL_FLOAT, densityGrid.getDensity().data());
+    }
 
-        float maxAge = static_cast<float>(trails[i].size() - 1);
-        for (size_t j = 0; j < trails[i].size(); ++j) {
-            trailData.push_back(trails[i][j].getX());
-            trailData.push_back(trails[i][j].getY());
-            trailData.push_back(j / maxAge);
-        }
+    glUseProgram(densityShaderProgram);
+    const float cellPx = static_cast<float>(densityGrid.getCellSize());
+    if (densityLoc_uGridScale >= 0) {
+        glUniform2f(densityLoc_uGridScale, viewW / (cols * cellPx), viewH / (rows * cellPx));
+    }
+    if (densityLoc_uLogMax >= 0) glUniform1f(densityLoc_uLogMax, std::log(1.0f + densityGrid.getMaxDensity()));
+    if (densityLoc_uSparse >= 0) glUniform1f(densityLoc_uSparse, static_cast<float>(densityGrid.getSparseThreshold()));
+    glBindVertexArray(backgroundVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Bodies in sparse cells keep their individual sprites; this replaces the culled
+    // upload, so the next culled frame packs again
+    subsetUploaded = false;
+    if (uploadPlanetSubset(planets, densityGrid.getSparseBodies())) drawPlanetSubset(camera);
+}
 
-        glBindBuffer(GL_ARRAY_BUFFER, trailVBO);
-        glBufferData(GL_ARRAY_BUFFER, trailData.size() * sizeof(float), trailData.data(), GL_DYNAMIC_DRAW);
 
-        const glm::vec3 c = planets[i].getColor();
-        glUniform3f(trailLoc_uColor, c.r, c.g, c.b);
+void Renderer::drawTrails(const TrailRecorder& trails, const std::vector<Planet>& planets, const Camera& camera) {
+    if (!trailsEnabled || planets.empty()) return;
+    PassTimer::Scope timed(passTimer, passTrails);
+    PLANETS_PROFILE_SCOPE("Trails");
+    MemoryTracker::TagScope tag(MemoryTracker::RenderBuffers);
+
+    glm::vec2 viewLo, viewHi;
+    camera.getVisibleRect(viewLo, viewHi);
+    auto segmentVisible = [&](const Vector2& a, const Vector2& b) {
+        return std::max(a.getX(), b.getX()) >= viewLo.x && std::min(a.getX(), b.getX()) <= viewHi.x &&
+               std::max(a.getY(), b.getY()) >= viewLo.y && std::min(a.getY(), b.getY()) <= viewHi.y;
+    };
 
-        glBindVertexArray(trailVAO);
-        glDrawArrays(GL_LINE_STRIP, 0, static_cast<GLsizei>(trails[i].size()));
+    // Buffers are reused between frames. All visible trail runs are packed into
+    // one stream and drawn with a single multi-draw.
+    trailVertices.clear();
+    runFirsts.clear();
+    runCounts.clear();
+
+    {
+        PLANETS_PROFILE_SCOPE("Pack");
+        for (size_t i = 0; i < trails.size() && i < planets.size(); ++i) {
+            const TrailRecorder::Trail& trail = trails.getTrail(i);
+            const size_t count = trail.size();
+            if (count < 2) continue;
+            // Whole trail off screen: skip without touching its points
+            if (trail.maxX < viewLo.x || trail.minX > viewHi.x || trail.maxY < viewLo.y || trail.minY > viewHi.y) continue;
+
+            const bool fullyInside = trail.minX >= viewLo.x && trail.maxX <= viewHi.x &&
+                                     trail.minY >= viewLo.y && trail.maxY <= viewHi.y;
+            const std::uint32_t color = packColor(planets[i].getColor());
+
+            // Points are decimated, so fade by sample time rather than by index. Age is 0
+            // at the newest point, which is drawn opaque and fades towards the oldest (the
+            // original per-frame trails had this reversed, fading out at the planet).
+            const double tOldest = trail.at(0).t;
+            const double span = std::max(trail.at(count - 1).t - tOldest, 1e-9);
+            auto emit = [&](size_t j) {
+                const TrailRecorder::TrailPoint& pt = trail.at(j);
+                const float age = static_cast<float>(1.0 - (pt.t - tOldest) / span);
+                trailVertices.push_back(TrailVertex{ pt.p.getX(), pt.p.getY(), age, color });
+            };
+            auto closeRun = [&](size_t first) {
+                const size_t n = trailVertices.size() - first;
+                if (n >= 2) {
+                    runFirsts.push_back(static_cast<GLint>(first));
+                    runCounts.push_back(static_cast<GLsizei>(n));
+                } else {
+                    trailVertices.resize(first);
+                }
+            };
+
+            if (fullyInside) {
+                const size_t first = trailVertices.size();
+                for (size_t j = 0; j < count; ++j) emit(j);
+                closeRun(first);
+                continue;
+            }
+
+            // Partially visible: split into runs of on-screen segments
+            bool open = false;
+            size_t first = 0;
+            for (size_t j = 1; j < count; ++j) {
+                if (segmentVisible(trail.at(j - 1).p, trail.at(j).p)) {
+                    if (!open) {
+                        first = trailVertices.size();
+                        emit(j - 1);
+                        open = true;
+                    }
+                    emit(j);
+                } else if (open) {
+                    closeRun(first);
+                    open = false;
+                }
+            }
+            if (open) closeRun(first);
+        }
+    }
+    if (runCounts.empty()) return;
+
+    PLANETS_PROFILE_SCOPE("Submit");
+    const size_t bytes = trailVertices.size() * sizeof(TrailVertex);
+    if (bytes > trailStream.regionSize()) {
+        size_t capacity = 4096;
+        while (capacity < trailVertices.size()) capacity *= 2;
+        if (!trailStream.create(GL_ARRAY_BUFFER, capacity * sizeof(TrailVertex))) return;
     }
+    void* dst = trailStream.beginWrite(bytes);
+    if (!dst) return;
+    std::memcpy(dst, trailVertices.data(), bytes);
+    trailStream.endWrite();
+
+    glUseProgram(trailShaderProgram);
+    glm::mat4 viewMatrix = camera.getViewMatrix();
+    glUniformMatrix4fv(trailLoc_uView, 1, GL_FALSE, glm::value_ptr(viewMatrix));
+
+    glBindVertexArray(trailVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, trailStream.id());
+    const size_t base = trailStream.currentOffset();
+    const GLsizei stride = sizeof(TrailVertex);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(TrailVertex, x)));
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(TrailVertex, age)));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(base + offsetof(TrailVertex, color)));
+    glMultiDrawArrays(GL_LINE_STRIP, runFirsts.data(), runCounts.data(), static_cast<GLsizei>(runCounts.size()));
+    trailStream.fence();
 
     glBindVertexArray(0);
     glUseProgram(0);
@@ -539,18 +897,50 @@ void Renderer::drawTrails(const std::vector<Planet>& planets, const Camera& came
 }
 
 void Renderer::endFrame() {
-    glfwSwapBuffers(window);
+    passTimer.endFrame();
+    PLANETS_PROFILE_SCOPE("Swap");
+    if (!headless) glfwSwapBuffers(window);
     glfwPollEvents();
 }
 
-bool Renderer::shouldClose() {
-    return glfwWindowShouldClose(window);
+void Renderer::onWindowEvent(GLFWwindow* win) {
+    if (auto* self = static_cast<Renderer*>(glfwGetWindowUserPointer(win))) ++self->eventSerial;
 }
 
-void Renderer::clearTrails() {
-    for (auto& trail : trails) {
-        trail.clear();
+bool Renderer::needsRedraw(const Simulation& sim, const Camera& camera) const {
+    if (settleFrames > 0 || eventSerial != drawnEventSerial) return true;
+    if (sim.getStateVersion() != drawnStateVersion || sim.getStaticVersion() != drawnStaticVersion) return true;
+    // Camera smoothing converges asymptotically; ignore sub-pixel drift
+    const glm::vec2 d = (camera.getPosition() - drawnCameraPos) * camera.getZoom();
+    return std::abs(d.x) > 1e-4f || std::abs(d.y) > 1e-4f ||
+           std::abs(camera.getZoom() - drawnCameraZoom) > 1e-4f * drawnCameraZoom;
+}
+
+void Renderer::markDrawn(const Simulation& sim, const Camera& camera) {
+    if (eventSerial != drawnEventSerial) {
+        settleFrames = REDRAW_SETTLE_FRAMES;
+    } else if (settleFrames > 0) {
+        --settleFrames;
     }
+    drawnEventSerial = eventSerial;
+    drawnStateVersion = sim.getStateVersion();
+    drawnStaticVersion = sim.getStaticVersion();
+    drawnCameraPos = camera.getPosition();
+    drawnCameraZoom = camera.getZoom();
+}
+
+void Renderer::waitEvents(double timeoutSeconds) {
+    glfwWaitEventsTimeout(timeoutSeconds);
+}
+
+bool Renderer::isMinimized() const {
+    if (headless) return false;
+    int fbW = 0, fbH = 0; glfwGetFramebufferSize(window, &fbW, &fbH);
+    return glfwGetWindowAttrib(window, GLFW_ICONIFIED) || fbW <= 0 || fbH <= 0;
+}
+
+bool Renderer::shouldClose() {
+    return glfwWindowShouldClose(window);
 }
 
 void Renderer::handleInput() {
@@ -560,6 +950,18 @@ void Renderer::handleInput() {
     // Camera pan controls moved to main.cpp for consistency
 }
 
+void Renderer::collectMemory(MemoryTracker::Report& report) const {
+    using MT = MemoryTracker;
+    report.addCpu(MT::RenderBuffers, capacityBytes(planetStatics) + capacityBytes(visibleBodies) +
+                                     capacityBytes(trailVertices) + capacityBytes(runFirsts) +
+                                     capacityBytes(runCounts) + densityGrid.memoryBytes());
+    report.addGpu(MT::RenderBuffers, planetStatics.size() * sizeof(PlanetStatic) + planetPositions.byteSize() +
+                                     planetInstances.byteSize() + trailStream.byteSize() +
+                                     static_cast<size_t>(densityTexCols) * densityTexRows * sizeof(float) +
+                                     static_cast<size_t>(starCount) * sizeof(Star) +
+                                     offscreen.byteSize() + sceneTarget.byteSize());
+}
+
 void Renderer::cleanup() {
     // Ensure the renderer's GL context is current before deleting GL resources.
     GLFWwindow* prevCtx = glfwGetCurrentContext();
@@ -573,6 +975,9 @@ void Renderer::cleanup() {
         imguiInitialized = false;
     }
 
+    offscreen.destroy();
+    sceneTarget.destroy();
+    passTimer.destroy();
     if (starShaderProgram) {
         glDeleteProgram(starShaderProgram);
         starShaderProgram = 0;
@@ -597,14 +1002,31 @@ void Renderer::cleanup() {
         glDeleteProgram(backgroundShaderProgram);
         backgroundShaderProgram = 0;
     }
-    if (planetVBO) {
-        glDeleteBuffers(1, &planetVBO);
-        planetVBO = 0;
+    if (planetStaticVBO) {
+        glDeleteBuffers(1, &planetStaticVBO);
+        planetStaticVBO = 0;
+    }
+    if (planetQuadVBO) {
+        glDeleteBuffers(1, &planetQuadVBO);
+        planetQuadVBO = 0;
+    }
+    if (planetSubsetVAO) {
+        glDeleteVertexArrays(1, &planetSubsetVAO);
+        planetSubsetVAO = 0;
+    }
+    planetInstances.destroy();
+    if (densityTexture) {
+        glDeleteTextures(1, &densityTexture);
+        densityTexture = 0;
+        densityTexCols = densityTexRows = 0;
     }
-    if (trailVBO) {
-        glDeleteBuffers(1, &trailVBO);
-        trailVBO = 0;
+    if (densityShaderProgram) {
+        glDeleteProgram(densityShaderProgram);
+        densityShaderProgram = 0;
     }
+    planetPositions.destroy();
+    uploadedPlanetCount = 0;
+    trailStream.destroy();
     if (backgroundVBO) {
         glDeleteBuffers(1, &backgroundVBO);
         backgroundVBO = 0;
@@ -0,0 +1,249 @@
+#include "planets/ShaderCache.hpp"
+#include <GLFW/glfw3.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+// ARB_get_program_binary is core in GL 4.1 but not part of the 3.3 glad loader
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC_)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC_)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC_)(GLuint program, GLenum pname, GLint value);
+
+namespace {
+
+struct ProgramBinaryApi {
+    PFNGLGETPROGRAMBINARYPROC_ getProgramBinary = nullptr;
+    PFNGLPROGRAMBINARYPROC_ programBinary = nullptr;
+    PFNGLPROGRAMPARAMETERIPROC_ programParameteri = nullptr;
+    bool available() const { return getProgramBinary && programBinary && programParameteri; }
+};
+
+const ProgramBinaryApi& loadProgramBinaryApi() {
+    static bool resolved = false;
+    static ProgramBinaryApi api;
+    if (!resolved) {
+        resolved = true;
+        const bool core41 = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 1);
+        GLint formats = 0;
+        if (core41 || glfwExtensionSupported("GL_ARB_get_program_binary")) {
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        }
+        // Drivers may expose the entry points yet support no binary formats
+        if (formats > 0) {
+            api.getProgramBinary = reinterpret_cast<PFNGLGETPROGRAMBINARYPROC_>(glfwGetProcAddress("glGetProgramBinary"));
+            api.programBinary = reinterpret_cast<PFNGLPROGRAMBINARYPROC_>(glfwGetProcAddress("glProgramBinary"));
+            api.programParameteri = reinterpret_cast<PFNGLPROGRAMPARAMETERIPROC_>(glfwGetProcAddress("glProgramParameteri"));
+        }
+    }
+    return api;
+}
+
+// 64-bit FNV-1a, chained over several strings
+std::uint64_t fnv1a(const std::string& s, std::uint64_t h = 0xcbf29ce484222325ull) {
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    // Separator so ("ab","c") and ("a","bc") differ
+    h ^= 0xff;
+    h *= 0x100000001b3ull;
+    return h;
+}
+
+constexpr char BINARY_MAGIC[4] = { 'P', 'P', 'B', '1' };
+
+GLuint compileShader(GLenum type, const std::string& src, const char* name) {
+    GLuint shader = glCreateShader(type);
+    const char* text = src.c_str();
+    glShaderSource(shader, 1, &text, nullptr);
+    glCompileShader(shader);
+
+    GLint success = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        GLint logLength = 0;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+        std::string log(static_cast<std::size_t>(logLength > 1 ? logLength : 1), '\0');
+        glGetShaderInfoLog(shader, logLength, nullptr, &log[0]);
+        std::cerr << "Shader '" << name << "' " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment")
+                  << " stage failed to compile:\n" << log.c_str() << "\n";
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint linkProgram(const std::string& vsSrc, const std::string& fsSrc, const char* name, bool retrievable) {
+    GLuint vs = compileShader(GL_VERTEX_SHADER, vsSrc, name);
+    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fsSrc, name);
+    if (!vs || !fs) {
+        if (vs) glDeleteShader(vs);
+        if (fs) glDeleteShader(fs);
+        return 0;
+    }
+
+    GLuint prog = glCreateProgram();
+    if (retrievable) {
+        loadProgramBinaryApi().programParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glAttachShader(prog, vs);
+    glAttachShader(prog, fs);
+    glLinkProgram(prog);
+    glDetachShader(prog, vs);
+    glDetachShader(prog, fs);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint success = GL_FALSE;
+    glGetProgramiv(prog, GL_LINK_STATUS, &success);
+    if (!success) {
+        GLint logLength = 0;
+        glGetProgramiv(prog, GL_INFO_LOG_LENGTH, &logLength);
+        std::string log(static_cast<std::size_t>(logLength > 1 ? logLength : 1), '\0');
+        glGetProgramInfoLog(prog, logLength, nullptr, &log[0]);
+        std::cerr << "Shader program '" << name << "' failed to link:\n" << log.c_str() << "\n";
+        glDeleteProgram(prog);
+        return 0;
+    }
+    return prog;
+}
+
+} // namespace
+
+ShaderCache::ShaderCache() {
+    const char* cacheEnv = std::getenv("PLANETS_SHADER_CACHE");
+    cacheDir = cacheEnv ? cacheEnv : "shader_cache";
+    const char* sourceEnv = std::getenv("PLANETS_SHADER_DIR");
+    if (sourceEnv) sourceDir = sourceEnv;
+}
+
+std::string ShaderCache::loadSource(const Source& src, bool& fromFile) const {
+    fromFile = false;
+    if (!sourceDir.empty() && src.file) {
+        const std::filesystem::path path = std::filesystem::path(sourceDir) / src.file;
+        std::ifstream in(path, std::ios::binary);
+        if (in) {
+            std::ostringstream text;
+            text << in.rdbuf();
+            fromFile = true;
+            return text.str();
+        }
+        // Seed missing files with the built-in source so there is something to edit
+        std::error_code ec;
+        std::filesystem::create_directories(sourceDir, ec);
+        std::ofstream out(path, std::ios::binary);
+        if (out) out << src.embedded;
+    }
+    return src.embedded;
+}
+
+std::string ShaderCache::cachePath(const char* name, const std::string& vs, const std::string& fs) {
+    if (driverId.empty()) {
+        auto str = [](GLenum e) {
+            const GLubyte* s = glGetString(e);
+            return s ? std::string(reinterpret_cast<const char*>(s)) : std::string();
+        };
+        driverId = str(GL_VENDOR) + "|" + str(GL_RENDERER) + "|" + str(GL_VERSION);
+    }
+    const std::uint64_t key = fnv1a(driverId, fnv1a(fs, fnv1a(vs)));
+    char file[96];
+    std::snprintf(file, sizeof(file), "%s-%016llx.bin", name, static_cast<unsigned long long>(key));
+    return (std::filesystem::path(cacheDir) / file).string();
+}
+
+GLuint ShaderCache::loadBinary(const std::string& path) const {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return 0;
+    char magic[4] = {};
+    std::uint32_t format = 0;
+    in.read(magic, 4);
+    in.read(reinterpret_cast<char*>(&format), sizeof(format));
+    if (!in || std::string(magic, 4) != std::string(BINARY_MAGIC, 4)) return 0;
+    const std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.empty()) return 0;
+
+    GLuint prog = glCreateProgram();
+    loadProgramBinaryApi().programBinary(prog, static_cast<GLenum>(format), data.data(), static_cast<GLsizei>(data.size()));
+    GLint success = GL_FALSE;
+    glGetProgramiv(prog, GL_LINK_STATUS, &success);
+    if (!success) {
+        // Stale or foreign binary: the driver rejects it and we rebuild from source
+        glDeleteProgram(prog);
+        return 0;
+    }
+    return prog;
+}
+
+void ShaderCache::storeBinary(const std::string& path, GLuint program) const {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+    std::vector<char> data(static_cast<std::size_t>(length));
+    GLenum format = 0;
+    GLsizei written = 0;
+    loadProgramBinaryApi().getProgramBinary(program, length, &written, &format, data.data());
+    if (written <= 0) return;
+
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir, ec);
+    // Write to a temporary name first so a concurrent launch never reads a partial file
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "ShaderCache: cannot write " << tmp << "\n";
+            return;
+        }
+        const std::uint32_t fmt = format;
+        out.write(BINARY_MAGIC, 4);
+        out.write(reinterpret_cast<const char*>(&fmt), sizeof(fmt));
+        out.write(data.data(), written);
+        if (!out) return;
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) std::filesystem::remove(tmp, ec);
+}
+
+GLuint ShaderCache::build(const char* name, const std::string& vsSrc, const std::string& fsSrc) {
+    const bool useCache = !cacheDir.empty() && loadProgramBinaryApi().available();
+    const std::string path = useCache ? cachePath(name, vsSrc, fsSrc) : std::string();
+    if (useCache) {
+        if (GLuint prog = loadBinary(path)) {
+            ++cacheHits;
+            return prog;
+        }
+    }
+
+    GLuint prog = linkProgram(vsSrc, fsSrc, name, useCache);
+    if (!prog) return 0;
+    ++compiled;
+    if (useCache) storeBinary(path, prog);
+    return prog;
+}
+
+GLuint ShaderCache::getProgram(const char* name, const Source& vs, const Source& fs) {
+    bool vsFromFile = false, fsFromFile = false;
+    const std::string vsSrc = loadSource(vs, vsFromFile);
+    const std::string fsSrc = loadSource(fs, fsFromFile);
+
+    GLuint prog = build(name, vsSrc, fsSrc);
+    if (!prog && (vsFromFile || fsFromFile)) {
+        std::cerr << "Shader program '" << name << "': falling back to built-in sources\n";
+        prog = build(name, vs.embedded, fs.embedded);
+    }
+    return prog;
+}
@@ -1,6 +1,10 @@
 #include "planets/Simulation.hpp"
+#include "planets/Profiler.hpp"
+#include "planets/PerfCounters.hpp"
 #include <random>
 #include <cmath>
+#include <cstdlib>
+#include <iostream>
 
 void Simulation::init() {
     planets.clear();
@@ -10,12 +14,11 @@ void Simulation::init() {
     planets.emplace_back(Vector2(0.0f, 0.0f), Vector2(0.5f, 0.0f));
     planets.back().setMass(5.0f);
 
-    // clear any external physics engine registrations
-    physics.clearBodies();
-    for (auto &pl : planets) physics.addBody(&pl);
+    registerBodies();
 }
 
 void Simulation::initRandom(int N, unsigned seed) {
+    MemoryTracker::TagScope tag(MemoryTracker::Bodies);
     planets.clear();
     std::mt19937 rng(seed);
     std::uniform_real_distribution<float> distPos(-2.5f, 2.5f);
@@ -43,18 +46,74 @@ void Simulation::initRandom(int N, unsigned seed) {
         planets.push_back(body);
     }
 
+    registerBodies();
+}
+
+void Simulation::registerBodies() {
+    MemoryTracker::TagScope tag(MemoryTracker::Bodies);
     // clear physics engine registrations
     physics.clearBodies();
     for (auto &pl : planets) physics.addBody(&pl);
+    physics.updateSums();
+
+    simTime = 0.0;
+    stepCount = 0;
+    trails.reset(planets.size());
+    ++stateVersion;
+    ++staticVersion;
 }
 
 void Simulation::step() {
     if (planets.empty()) return;
+    const std::uint64_t allocationsBefore = MemoryTracker::threadAllocations();
     // Delegate physics computations to PhysicsEngine
-    physics.computeForces(deltaTime);
-    physics.integrate(deltaTime);
+    const std::uint64_t n = planets.size();
+    {
+        PLANETS_PROFILE_SCOPE("Forces");
+        PerfCounters::Scope counted(PerfCounters::Forces, n * (n - 1) / 2);
+        physics.computeForces();
+    }
+    {
+        PLANETS_PROFILE_SCOPE("Integrate");
+        PerfCounters::Scope counted(PerfCounters::Integrate, n);
+        physics.integrate(deltaTime);
+    }
+    simTime += deltaTime;
+    ++stateVersion;
+    {
+        PLANETS_PROFILE_SCOPE("Trail record");
+        trails.record(planets, simTime);
+    }
+
+    ++stepCount;
+    if (allocationWarmup >= 0 && stepCount > static_cast<std::uint64_t>(allocationWarmup)) {
+        const std::uint64_t allocations = MemoryTracker::threadAllocations() - allocationsBefore;
+        if (allocations > 0) allocationCheckFailed(allocations);
+    }
+}
+
+void Simulation::allocationCheckFailed(std::uint64_t allocations) const {
+    std::cerr << "Simulation::step allocated " << allocations << " time(s) at step " << stepCount
+              << " (steady state expected after " << allocationWarmup << " steps, "
+              << planets.size() << " bodies)\n";
+    std::abort();
+}
+
+void Simulation::collectMemory(MemoryTracker::Report& report) const {
+    report.addCpu(MemoryTracker::Bodies, capacityBytes(planets) + physics.memoryBytes());
+    report.addCpu(MemoryTracker::Trails, trails.memoryBytes());
+    report.addCpu(MemoryTracker::SpatialIndex, spatialIndex.memoryBytes());
 }
 
 void Simulation::update() {
     step();
 }
+
+const SpatialGrid& Simulation::getSpatialIndex() const {
+    if (spatialIndexVersion != stateVersion) {
+        MemoryTracker::TagScope tag(MemoryTracker::SpatialIndex);
+        spatialIndex.build(planets);
+        spatialIndexVersion = stateVersion;
+    }
+    return spatialIndex;
+}
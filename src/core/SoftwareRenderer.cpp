@@ -0,0 +1,242 @@
+#include "planets/SoftwareRenderer.hpp"
+#include "planets/Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PLANETS_SOFTRAST_SSE 1
+#endif
+
+namespace {
+
+inline float smoothstep(float e0, float e1, float x) {
+    const float t = std::clamp((x - e0) / (e1 - e0), 0.0f, 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+// dst = dst + (src - dst) * a on one RGBA pixel; src.a == a, which reproduces
+// glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA) on all four channels
+inline void blend(float* dst, float r, float g, float b, float a) {
+    if (a <= 0.0f) return;
+#ifdef PLANETS_SOFTRAST_SSE
+    const __m128 d = _mm_loadu_ps(dst);
+    const __m128 s = _mm_set_ps(a, b, g, r);
+    _mm_storeu_ps(dst, _mm_add_ps(d, _mm_mul_ps(_mm_sub_ps(s, d), _mm_set1_ps(a))));
+#else
+    dst[0] += (r - dst[0]) * a;
+    dst[1] += (g - dst[1]) * a;
+    dst[2] += (b - dst[2]) * a;
+    dst[3] += (a - dst[3]) * a;
+#endif
+}
+
+inline std::uint8_t toUnorm8(float v) {
+    return static_cast<std::uint8_t>(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+} // namespace
+
+SoftwareRenderer::SoftwareRenderer(int w, int h) : stars(generateStarfield()) {
+    resize(w, h);
+}
+
+void SoftwareRenderer::resize(int w, int h) {
+    width = std::max(1, w);
+    height = std::max(1, h);
+    tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    tileBins.assign(static_cast<std::size_t>(tilesX) * tilesY, {});
+    pixels.assign(static_cast<std::size_t>(width) * height * 4, 0);
+}
+
+void SoftwareRenderer::addPrim(const Prim& p, float minX, float minY, float maxX, float maxY) {
+    if (maxX < 0.0f || maxY < 0.0f || minX >= static_cast<float>(width) || minY >= static_cast<float>(height)) return;
+    const int tx0 = std::max(0, static_cast<int>(minX) / TILE_SIZE);
+    const int ty0 = std::max(0, static_cast<int>(minY) / TILE_SIZE);
+    const int tx1 = std::min(tilesX - 1, static_cast<int>(maxX) / TILE_SIZE);
+    const int ty1 = std::min(tilesY - 1, static_cast<int>(maxY) / TILE_SIZE);
+    const std::uint32_t index = static_cast<std::uint32_t>(prims.size());
+    prims.push_back(p);
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            tileBins[static_cast<std::size_t>(ty) * tilesX + tx].push_back(index);
+        }
+    }
+}
+
+void SoftwareRenderer::buildPrims(const Simulation& sim, const Camera& camera) {
+    prims.clear();
+    for (auto& bin : tileBins) bin.clear();
+
+    const float W = static_cast<float>(width), H = static_cast<float>(height);
+    const glm::vec2 cam = camera.getPosition();
+    const float zoom = camera.getZoom();
+    auto toPixel = [&](float x, float y) {
+        return glm::vec2(((x - cam.x) * zoom + 1.0f) * 0.5f * W, ((y - cam.y) * zoom + 1.0f) * 0.5f * H);
+    };
+
+    // Starfield: constant 2 px points in NDC
+    if (starfieldEnabled) {
+        for (const Star& s : stars) {
+            const float cx = (s.x + 1.0f) * 0.5f * W, cy = (s.y + 1.0f) * 0.5f * H;
+            addPrim(Prim{ PrimType::Star, cx, cy, 1.0f, 0.0f, 1.0f, 1.0f, s.r, s.g, s.b },
+                    cx - 1.0f, cy - 1.0f, cx + 1.0f, cy + 1.0f);
+        }
+    }
+
+    const std::vector<Planet>& planets = sim.getPlanets();
+
+    // Trails: one segment per consecutive point pair, alpha fading with sample age
+    if (trailsEnabled) {
+        const TrailRecorder& trails = sim.getTrails();
+        for (std::size_t i = 0; i < trails.size() && i < planets.size(); ++i) {
+            const TrailRecorder::Trail& trail = trails.getTrail(i);
+            const std::size_t count = trail.size();
+            if (count < 2) continue;
+            const glm::vec3 c = planets[i].getColor();
+            // Newest point opaque, as in Renderer::drawTrails
+            const double tOldest = trail.at(0).t;
+            const double span = std::max(trail.at(count - 1).t - tOldest, 1e-9);
+            auto alphaAt = [&](std::size_t j) {
+                const float age = static_cast<float>(1.0 - (trail.at(j).t - tOldest) / span);
+                return std::clamp(1.0f - age, 0.0f, 1.0f) * 0.6f;
+            };
+            glm::vec2 prev = toPixel(trail.at(0).p.getX(), trail.at(0).p.getY());
+            float prevA = alphaAt(0);
+            for (std::size_t j = 1; j < count; ++j) {
+                const glm::vec2 cur = toPixel(trail.at(j).p.getX(), trail.at(j).p.getY());
+                const float curA = alphaAt(j);
+                addPrim(Prim{ PrimType::Segment, prev.x, prev.y, cur.x, cur.y, prevA, curA, c.r, c.g, c.b },
+                        std::min(prev.x, cur.x) - 1.0f, std::min(prev.y, cur.y) - 1.0f,
+                        std::max(prev.x, cur.x) + 1.0f, std::max(prev.y, cur.y) + 1.0f);
+                prev = cur;
+                prevA = curA;
+            }
+        }
+    }
+
+    // Planet sprites: same size rule as the GL vertex shader
+    const float pixelPerWorld = zoom * H * 0.5f;
+    for (const Planet& planet : planets) {
+        const glm::vec2 c = toPixel(planet.getP().getX(), planet.getP().getY());
+        const float r = planet.getRadius();
+        const float ps = std::max(2.5f, std::max(r * planetRadiusScale * 3.0f, 2.0f * r * pixelPerWorld));
+        const float half = 0.5f * ps;
+        const glm::vec3 col = planet.getColor();
+        addPrim(Prim{ PrimType::Sprite, c.x, c.y, half, 0.0f, 1.0f, 1.0f, col.r, col.g, col.b },
+                c.x - half, c.y - half, c.x + half, c.y + half);
+    }
+}
+
+void SoftwareRenderer::rasterTile(int tx, int ty, float* tile) {
+    const int x0 = tx * TILE_SIZE, y0 = ty * TILE_SIZE;
+    const int x1 = std::min(width, x0 + TILE_SIZE), y1 = std::min(height, y0 + TILE_SIZE);
+    const int tw = x1 - x0;
+
+    // Clear colour (0,0,0,1) as in Renderer::beginFrame
+    for (int i = 0; i < TILE_SIZE * TILE_SIZE; ++i) {
+        tile[4 * i + 0] = 0.0f; tile[4 * i + 1] = 0.0f; tile[4 * i + 2] = 0.0f; tile[4 * i + 3] = 1.0f;
+    }
+    auto px = [&](int x, int y) { return tile + 4 * ((y - y0) * TILE_SIZE + (x - x0)); };
+
+    for (std::uint32_t index : tileBins[static_cast<std::size_t>(ty) * tilesX + tx]) {
+        const Prim& p = prims[index];
+        switch (p.type) {
+            case PrimType::Star:
+            case PrimType::Sprite: {
+                // Square footprint of half size x1 around (x0, y0); pixel centres inside it
+                const float half = p.x1;
+                const int bx0 = std::max(x0, static_cast<int>(std::ceil(p.x0 - half - 0.5f)));
+                const int by0 = std::max(y0, static_cast<int>(std::ceil(p.y0 - half - 0.5f)));
+                const int bx1 = std::min(x1 - 1, static_cast<int>(std::floor(p.x0 + half - 0.5f)));
+                const int by1 = std::min(y1 - 1, static_cast<int>(std::floor(p.y0 + half - 0.5f)));
+                const float inv = 1.0f / half;
+                for (int y = by0; y <= by1; ++y) {
+                    const float dy = (y + 0.5f - p.y0) * inv * 0.5f;
+                    for (int x = bx0; x <= bx1; ++x) {
+                        const float dx = (x + 0.5f - p.x0) * inv * 0.5f;
+                        const float d2 = dx * dx + dy * dy;
+                        const float a = p.type == PrimType::Star
+                            ? 1.0f - smoothstep(0.0f, 0.6f * 0.6f, d2)
+                            : 1.0f - smoothstep(0.45f * 0.45f, 0.5f * 0.5f, d2);
+                        blend(px(x, y), p.r, p.g, p.b, a);
+                    }
+                }
+                break;
+            }
+            case PrimType::Segment: {
+                // 1 px DDA along the major axis, sampling at pixel centres
+                const float dx = p.x1 - p.x0, dy = p.y1 - p.y0;
+                const bool xMajor = std::abs(dx) >= std::abs(dy);
+                const float major = xMajor ? dx : dy;
+                if (std::abs(major) < 1e-6f) break;
+                const float start = xMajor ? p.x0 : p.y0;
+                const float lo = std::min(start, start + major), hi = std::max(start, start + major);
+                const int clipLo = xMajor ? x0 : y0, clipHi = xMajor ? x1 : y1;
+                const int i0 = std::max(clipLo, static_cast<int>(std::ceil(lo - 0.5f)));
+                const int i1 = std::min(clipHi - 1, static_cast<int>(std::ceil(hi - 0.5f)) - 1);
+                for (int i = i0; i <= i1; ++i) {
+                    const float t = (i + 0.5f - start) / major;
+                    const float minor = xMajor ? p.y0 + t * dy : p.x0 + t * dx;
+                    const int j = static_cast<int>(std::floor(minor));
+                    const int x = xMajor ? i : j, y = xMajor ? j : i;
+                    if (x < x0 || x >= x1 || y < y0 || y >= y1) continue;
+                    blend(px(x, y), p.r, p.g, p.b, p.a0 + (p.a1 - p.a0) * t);
+                }
+                break;
+            }
+        }
+    }
+
+    // Resolve to RGBA8 (bottom-up rows, like a GL readback)
+    for (int y = y0; y < y1; ++y) {
+        const float* src = px(x0, y);
+        std::uint8_t* dst = &pixels[(static_cast<std::size_t>(y) * width + x0) * 4];
+        for (int i = 0; i < tw * 4; ++i) dst[i] = toUnorm8(src[i]);
+    }
+}
+
+void SoftwareRenderer::collectMemory(MemoryTracker::Report& report) const {
+    std::size_t bytes = capacityBytes(stars) + capacityBytes(prims) + capacityBytes(tileBins) +
+                        capacityBytes(chunkScratch) + capacityBytes(pixels);
+    for (const auto& bin : tileBins) bytes += capacityBytes(bin);
+    for (const auto& scratch : chunkScratch) bytes += capacityBytes(scratch);
+    report.addCpu(MemoryTracker::RenderBuffers, bytes);
+}
+
+void SoftwareRenderer::render(const Simulation& sim, const Camera& camera) {
+    MemoryTracker::TagScope tag(MemoryTracker::RenderBuffers);
+    buildPrims(sim, camera);
+
+    const unsigned chunks = parallel::maxChunks();
+    if (chunkScratch.size() < chunks) chunkScratch.resize(chunks);
+    const std::size_t tileCount = static_cast<std::size_t>(tilesX) * tilesY;
+    parallel::forRange(tileCount, 1, [&](std::size_t begin, std::size_t end, unsigned c) {
+        std::vector<float>& scratch = chunkScratch[c];
+        scratch.resize(TILE_SIZE * TILE_SIZE * 4);
+        for (std::size_t t = begin; t < end; ++t) {
+            rasterTile(static_cast<int>(t % tilesX), static_cast<int>(t / tilesX), scratch.data());
+        }
+    });
+}
+
+SoftwareRenderer::ImageDiff SoftwareRenderer::compare(const std::uint8_t* a, const std::uint8_t* b, int w, int h) {
+    ImageDiff diff;
+    const std::size_t n = static_cast<std::size_t>(w) * h;
+    if (n == 0) return diff;
+    double sumAbs = 0.0, sumSq = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            const int d = std::abs(static_cast<int>(a[4 * i + c]) - static_cast<int>(b[4 * i + c]));
+            diff.maxAbs = std::max(diff.maxAbs, d);
+            sumAbs += d;
+            sumSq += static_cast<double>(d) * d;
+        }
+    }
+    diff.meanAbs = sumAbs / (3.0 * n);
+    const double mse = sumSq / (3.0 * n);
+    diff.psnr = mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : std::numeric_limits<double>::infinity();
+    return diff;
+}
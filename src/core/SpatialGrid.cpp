@@ -0,0 +1,129 @@
+#include "planets/SpatialGrid.hpp"
+#include "planets/MemoryTracker.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Cell index of a world offset from the grid origin. Clamped while still a float, since
+// converting an out-of-range value (extreme zoom, diverged body, inf) to int is undefined;
+// NaN goes to cell 0.
+static int clampCell(float offset, float inv, int count) {
+    const float c = std::floor(offset * inv);
+    if (!(c >= 0.0f)) return 0;
+    return static_cast<int>(std::min(c, static_cast<float>(count - 1)));
+}
+
+std::size_t SpatialGrid::memoryBytes() const {
+    return capacityBytes(cellStart) + capacityBytes(items) + capacityBytes(itemPos) + capacityBytes(cellOf);
+}
+
+void SpatialGrid::build(const std::vector<Planet>& planets) {
+    const std::size_t n = planets.size();
+    items.resize(n);
+    itemPos.resize(n);
+    cellOf.resize(n);
+    if (n == 0) {
+        cols = rows = 0;
+        cellStart.assign(1, 0u);
+        return;
+    }
+
+    glm::vec2 lo(std::numeric_limits<float>::max());
+    glm::vec2 hi(std::numeric_limits<float>::lowest());
+    maxRadius = 0.0f;
+    for (const auto& p : planets) {
+        const float x = p.getP().getX(), y = p.getP().getY();
+        // A diverged body would stretch the grid to infinity; it still gets a cell below
+        if (!std::isfinite(x) || !std::isfinite(y)) continue;
+        lo.x = std::min(lo.x, x); lo.y = std::min(lo.y, y);
+        hi.x = std::max(hi.x, x); hi.y = std::max(hi.y, y);
+        maxRadius = std::max(maxRadius, p.getRadius());
+    }
+    if (lo.x > hi.x) lo = hi = glm::vec2(0.0f); // no finite position at all
+    boundsMin = lo;
+    boundsMax = hi;
+
+    // Aim for a few bodies per cell, with cells roughly square in world space
+    const float w = std::max(hi.x - lo.x, 1e-6f);
+    const float h = std::max(hi.y - lo.y, 1e-6f);
+    const double targetCells = std::max(1.0, static_cast<double>(n) / 4.0);
+    const double aspect = static_cast<double>(w) / static_cast<double>(h);
+    cols = static_cast<int>(std::clamp(std::sqrt(targetCells * aspect), 1.0, 2048.0));
+    rows = static_cast<int>(std::clamp(targetCells / cols, 1.0, 2048.0));
+    invCellSize = glm::vec2(cols / w, rows / h);
+
+    const std::size_t cellCount = static_cast<std::size_t>(cols) * rows;
+    cellStart.assign(cellCount + 1, 0u);
+    for (std::size_t i = 0; i < n; ++i) {
+        const Vector2& p = planets[i].getP();
+        const int cx = clampCell(p.getX() - lo.x, invCellSize.x, cols);
+        const int cy = clampCell(p.getY() - lo.y, invCellSize.y, rows);
+        const std::uint32_t cell = static_cast<std::uint32_t>(cy) * cols + cx;
+        cellOf[i] = cell;
+        ++cellStart[cell + 1];
+    }
+    for (std::size_t c = 0; c < cellCount; ++c) cellStart[c + 1] += cellStart[c];
+
+    // Scatter; cellOf doubles as the running write cursor per cell
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::uint32_t slot = cellStart[cellOf[i]]++;
+        items[slot] = static_cast<std::uint32_t>(i);
+        itemPos[slot] = glm::vec2(planets[i].getP().getX(), planets[i].getP().getY());
+    }
+    // The scatter advanced every start to the next cell's start; shift back
+    for (std::size_t c = cellCount; c > 0; --c) cellStart[c] = cellStart[c - 1];
+    cellStart[0] = 0;
+}
+
+bool SpatialGrid::cellRange(glm::vec2 lo, glm::vec2 hi, int& x0, int& y0, int& x1, int& y1) const {
+    if (items.empty()) return false;
+    if (std::isnan(lo.x) || std::isnan(lo.y) || std::isnan(hi.x) || std::isnan(hi.y)) return false;
+    if (hi.x < boundsMin.x || hi.y < boundsMin.y || lo.x > boundsMax.x || lo.y > boundsMax.y) return false;
+    x0 = clampCell(lo.x - boundsMin.x, invCellSize.x, cols);
+    x1 = clampCell(hi.x - boundsMin.x, invCellSize.x, cols);
+    y0 = clampCell(lo.y - boundsMin.y, invCellSize.y, rows);
+    y1 = clampCell(hi.y - boundsMin.y, invCellSize.y, rows);
+    return true;
+}
+
+void SpatialGrid::queryRect(glm::vec2 lo, glm::vec2 hi, std::vector<std::uint32_t>& out) const {
+    forEachCandidate(lo, hi, [&](std::uint32_t index, const glm::vec2& p) {
+        if (p.x >= lo.x && p.x <= hi.x && p.y >= lo.y && p.y <= hi.y) out.push_back(index);
+    });
+}
+
+void SpatialGrid::queryRadius(glm::vec2 center, float radius, std::vector<std::uint32_t>& out) const {
+    const float r2 = radius * radius;
+    forEachCandidate(center - glm::vec2(radius), center + glm::vec2(radius), [&](std::uint32_t index, const glm::vec2& p) {
+        const glm::vec2 d = p - center;
+        if (d.x * d.x + d.y * d.y <= r2) out.push_back(index);
+    });
+}
+
+int SpatialGrid::nearest(glm::vec2 p, float maxDist) const {
+    if (items.empty()) return -1;
+    // Any body outside the square of half-size `reach` is farther than reach, so the
+    // search can stop once the best hit lies within it. Start at about one cell.
+    const glm::vec2 cell(1.0f / invCellSize.x, 1.0f / invCellSize.y);
+    // Distance beyond which the square already covers every body
+    const float cover = std::max(std::max(std::abs(p.x - boundsMin.x), std::abs(p.x - boundsMax.x)),
+                                 std::max(std::abs(p.y - boundsMin.y), std::abs(p.y - boundsMax.y)));
+    float reach = std::min(std::max(cell.x, cell.y), maxDist);
+    for (;;) {
+        int best = -1;
+        float bestD2 = std::numeric_limits<float>::max();
+        forEachCandidate(p - glm::vec2(reach), p + glm::vec2(reach), [&](std::uint32_t index, const glm::vec2& q) {
+            const glm::vec2 d = q - p;
+            const float d2 = d.x * d.x + d.y * d.y;
+            if (d2 < bestD2) {
+                bestD2 = d2;
+                best = static_cast<int>(index);
+            }
+        });
+        if (best >= 0 && bestD2 <= reach * reach) return best;
+        if (reach >= maxDist || reach >= cover) {
+            return (best >= 0 && bestD2 <= maxDist * maxDist) ? best : -1;
+        }
+        reach = std::min(reach * 2.0f, maxDist);
+    }
+}
@@ -0,0 +1,34 @@
+#include "planets/Starfield.hpp"
+#include <random>
+
+std::vector<Star> generateStarfield(int count, unsigned seed) {
+    std::vector<Star> stars;
+    stars.reserve(count);
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dpos(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> dcol(0.75f, 1.0f);
+    std::uniform_int_distribution<int> huePick(0, 2);
+
+    for (int i = 0; i < count; ++i) {
+        float x = dpos(rng);
+        float y = dpos(rng);
+        int hue = huePick(rng);
+        float r = dcol(rng), g = dcol(rng), b = dcol(rng);
+
+        switch (hue) {
+            case 0: // pale blue
+                r *= 0.85f; g *= 0.92f; b *= 1.00f;
+                break;
+            case 1: // pale yellow
+                r *= 1.00f; g *= 0.95f; b *= 0.85f;
+                break;
+            case 2: // neutral white
+                r *= 0.95f; g *= 0.98f; b *= 1.00f;
+            break;
+        }
+
+        stars.push_back(Star{ x, y, r, g, b });
+    }
+    return stars;
+}
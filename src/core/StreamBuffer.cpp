@@ -0,0 +1,114 @@
+#include "planets/StreamBuffer.hpp"
+#include <GLFW/glfw3.h>
+
+// ARB_buffer_storage is core in GL 4.4 but not part of the 3.3 glad loader
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC_)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+static PFNGLBUFFERSTORAGEPROC_ loadBufferStorage() {
+    static bool resolved = false;
+    static PFNGLBUFFERSTORAGEPROC_ fn = nullptr;
+    if (!resolved) {
+        resolved = true;
+        const bool core44 = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4);
+        if (core44 || glfwExtensionSupported("GL_ARB_buffer_storage")) {
+            fn = reinterpret_cast<PFNGLBUFFERSTORAGEPROC_>(glfwGetProcAddress("glBufferStorage"));
+        }
+    }
+    return fn;
+}
+
+bool StreamBuffer::create(GLenum tgt, std::size_t bytesPerRegion) {
+    destroy();
+    target = tgt;
+    regionBytes = bytesPerRegion;
+    const GLsizeiptr total = static_cast<GLsizeiptr>(regionBytes * REGIONS);
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+
+    if (PFNGLBUFFERSTORAGEPROC_ bufferStorage = loadBufferStorage()) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(target, total, nullptr, flags);
+        mapped = glMapBufferRange(target, 0, total, flags);
+        persistent = (mapped != nullptr);
+    }
+    if (!persistent) {
+        // Mutable storage fallback: allocated once, regions mapped per write
+        glBufferData(target, total, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(target, 0);
+    region = REGIONS - 1;
+    return buffer != 0;
+}
+
+void StreamBuffer::destroy() {
+    for (GLsync& f : fences) {
+        if (f) glDeleteSync(f);
+        f = nullptr;
+    }
+    if (buffer) {
+        if (mapped) {
+            glBindBuffer(target, buffer);
+            glUnmapBuffer(target);
+            glBindBuffer(target, 0);
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+    buffer = 0;
+    mapped = nullptr;
+    persistent = false;
+    writing = false;
+    regionBytes = 0;
+}
+
+void StreamBuffer::waitForRegion(int r) {
+    GLsync f = fences[r];
+    if (!f) return;
+    // Flush once so the fence is guaranteed to signal, then poll in 1 ms slices
+    GLenum status = glClientWaitSync(f, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(f, 0, 1000000);
+    }
+    glDeleteSync(f);
+    fences[r] = nullptr;
+}
+
+void* StreamBuffer::beginWrite(std::size_t bytes) {
+    if (!buffer || bytes > regionBytes || writing) return nullptr;
+    region = (region + 1) % REGIONS;
+    waitForRegion(region);
+    writing = true;
+
+    if (persistent) {
+        return static_cast<char*>(mapped) + currentOffset();
+    }
+    glBindBuffer(target, buffer);
+    const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+    void* ptr = glMapBufferRange(target, static_cast<GLintptr>(currentOffset()), static_cast<GLsizeiptr>(bytes), access);
+    if (!ptr) {
+        glBindBuffer(target, 0);
+        writing = false;
+    }
+    return ptr;
+}
+
+void StreamBuffer::endWrite() {
+    if (!writing) return;
+    writing = false;
+    if (persistent) return; // coherent mapping: writes are visible to later commands
+    glBindBuffer(target, buffer);
+    glUnmapBuffer(target);
+    glBindBuffer(target, 0);
+}
+
+void StreamBuffer::fence() {
+    if (!buffer) return;
+    if (fences[region]) glDeleteSync(fences[region]);
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,159 @@
+#include "planets/Tracer.hpp"
+#include "planets/MemoryTracker.hpp"
+#include <cstdio>
+#include <iostream>
+
+std::atomic<bool> Tracer::recordingFlag{false};
+
+namespace {
+// Per-thread state: the ring is created on the first recorded event, so threads
+// that never record while a capture runs cost nothing
+thread_local std::string threadName;
+thread_local void* threadRing = nullptr;
+
+void writeEscaped(std::FILE* f, const char* s) {
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') std::fputc('\\', f);
+        std::fputc(*s, f);
+    }
+}
+}
+
+Tracer& Tracer::get() {
+    static Tracer instance;
+    return instance;
+}
+
+void Tracer::setThreadName(const std::string& name) {
+    threadName = name;
+    if (threadRing) {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        static_cast<ThreadRing*>(threadRing)->name = name;
+    }
+}
+
+Tracer::ThreadRing* Tracer::ring() {
+    if (!threadRing) {
+        MemoryTracker::TagScope tag(MemoryTracker::IO);
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        rings.push_back(std::make_unique<ThreadRing>());
+        ThreadRing* r = rings.back().get();
+        r->tid = static_cast<int>(rings.size());
+        r->name = threadName.empty() ? "Thread " + std::to_string(r->tid) : threadName;
+        threadRing = r;
+    }
+    return static_cast<ThreadRing*>(threadRing);
+}
+
+std::size_t Tracer::memoryBytes() {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    return capacityBytes(rings) + rings.size() * sizeof(ThreadRing);
+}
+
+void Tracer::record(const char* name, Clock::time_point t, char phase) {
+    if (!recording()) return;
+    ThreadRing* r = ring();
+    const std::uint64_t h = r->head.load(std::memory_order_relaxed);
+    if (h - r->start.load(std::memory_order_acquire) >= RING_EVENTS) {
+        r->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    r->events[h & (RING_EVENTS - 1)] = Event{ name, std::chrono::duration_cast<std::chrono::nanoseconds>(t - epoch).count(), phase };
+    r->head.store(h + 1, std::memory_order_release);
+}
+
+void Tracer::capture(const std::string& outPath, int frames, int skip) {
+    if (recording()) finish();
+    path = outPath;
+    framesLeft = frames > 0 ? frames : 1;
+    skipFrames = skip > 0 ? skip : 0;
+    armed = true;
+}
+
+void Tracer::beginFrame() {
+    if (!armed) return;
+    const Clock::time_point now = Clock::now();
+    // The previous iteration returned early without drawing
+    if (frameOpen) {
+        end("Frame", now);
+        frameOpen = false;
+    }
+    if (!recording()) {
+        if (skipFrames > 0) {
+            --skipFrames;
+            return;
+        }
+        // Events before this point belong to no capture
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for (auto& r : rings) {
+            r->start.store(r->head.load(std::memory_order_acquire), std::memory_order_release);
+            r->dropped.store(0, std::memory_order_relaxed);
+        }
+        recordingFlag.store(true, std::memory_order_relaxed);
+    }
+    begin("Frame", now);
+    frameOpen = true;
+}
+
+void Tracer::endFrame() {
+    if (!frameOpen) return;
+    end("Frame", Clock::now());
+    frameOpen = false;
+    if (--framesLeft <= 0) finish();
+}
+
+void Tracer::finish() {
+    if (!armed) return;
+    if (frameOpen) {
+        end("Frame", Clock::now());
+        frameOpen = false;
+    }
+    const bool recorded = recording();
+    recordingFlag.store(false, std::memory_order_relaxed);
+    armed = false;
+    if (recorded) write();
+}
+
+bool Tracer::write() {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        std::cerr << "Tracer: cannot open " << path << "\n";
+        return false;
+    }
+
+    // Threads still inside a scope may append after this point; only events published
+    // before the head is read are written
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    std::uint64_t written = 0, dropped = 0;
+    std::fputs("{\"traceEvents\":[\n", f);
+    bool first = true;
+    for (const auto& r : rings) {
+        std::fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"",
+                     first ? "" : ",\n", r->tid);
+        writeEscaped(f, r->name.c_str());
+        std::fputs("\"}}", f);
+        first = false;
+
+        const std::uint64_t start = r->start.load(std::memory_order_acquire);
+        const std::uint64_t head = r->head.load(std::memory_order_acquire);
+        for (std::uint64_t i = start; i < head; ++i) {
+            const Event& e = r->events[i & (RING_EVENTS - 1)];
+            std::fputs(",\n{\"name\":\"", f);
+            writeEscaped(f, e.name);
+            std::fprintf(f, "\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}", e.phase, e.ns / 1000.0, r->tid);
+        }
+        written += head - start;
+        dropped += r->dropped.load(std::memory_order_relaxed);
+    }
+    std::fprintf(f, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":%llu}}\n",
+                 static_cast<unsigned long long>(dropped));
+    const bool ok = std::fclose(f) == 0;
+    if (!ok) {
+        std::cerr << "Tracer: failed writing " << path << "\n";
+        return false;
+    }
+    std::cout << "Trace written to " << path << " (" << written << " events";
+    if (dropped) std::cout << ", " << dropped << " dropped";
+    std::cout << ")\n";
+    return true;
+}
@@ -0,0 +1,128 @@
+#include "planets/TrailRecorder.hpp"
+#include "planets/MemoryTracker.hpp"
+#include <algorithm>
+#include <cmath>
+
+void TrailRecorder::setEnabled(bool e) {
+    if (e == enabled) return;
+    enabled = e;
+    clear();
+}
+
+void TrailRecorder::setCapacity(std::size_t points) {
+    capacity = std::max<std::size_t>(2, points);
+    clear();
+}
+
+void TrailRecorder::reset(std::size_t bodyCount) {
+    MemoryTracker::TagScope tag(MemoryTracker::Trails);
+    trails.clear();
+    trails.resize(bodyCount);
+    clear();
+}
+
+// Enabled trails are reserved at full size here, so recording never allocates
+void TrailRecorder::clear() {
+    MemoryTracker::TagScope tag(MemoryTracker::Trails);
+    for (auto& trail : trails) {
+        trail.head = 0;
+        if (enabled) {
+            trail.ring.clear();
+            trail.pending.clear();
+            trail.ring.reserve(capacity);
+            trail.pending.reserve(maxPending);
+        } else {
+            std::vector<TrailPoint>().swap(trail.ring);
+            std::vector<TrailPoint>().swap(trail.pending);
+        }
+    }
+    hasSampled = false;
+}
+
+std::size_t TrailRecorder::memoryBytes() const {
+    std::size_t bytes = capacityBytes(trails);
+    for (const auto& trail : trails) bytes += capacityBytes(trail.ring) + capacityBytes(trail.pending);
+    return bytes;
+}
+
+void TrailRecorder::sample(const std::vector<Planet>& planets, double simTime) {
+    MemoryTracker::TagScope tag(MemoryTracker::Trails);
+    if (trails.size() != planets.size()) reset(planets.size());
+    lastSampleTime = simTime;
+    hasSampled = true;
+
+    for (std::size_t i = 0; i < planets.size(); ++i) {
+        push(trails[i], TrailPoint{ planets[i].getP(), simTime });
+    }
+}
+
+void TrailRecorder::push(Trail& trail, const TrailPoint& pt) {
+    if (trail.ring.empty()) {
+        trail.minX = trail.maxX = pt.p.getX();
+        trail.minY = trail.maxY = pt.p.getY();
+        commit(trail, pt);
+        return;
+    }
+
+    // Extend the pending run while its chord still represents every sample in it;
+    // otherwise the last sample that did fit becomes the new anchor.
+    if (!trail.pending.empty() && (trail.pending.size() >= maxPending || !chordFits(trail, pt))) {
+        const TrailPoint anchor = trail.pending.back();
+        trail.pending.clear();
+        commit(trail, anchor);
+    }
+    trail.pending.push_back(pt);
+
+    trail.minX = std::min(trail.minX, pt.p.getX());
+    trail.maxX = std::max(trail.maxX, pt.p.getX());
+    trail.minY = std::min(trail.minY, pt.p.getY());
+    trail.maxY = std::max(trail.maxY, pt.p.getY());
+}
+
+void TrailRecorder::commit(Trail& trail, const TrailPoint& pt) {
+    if (trail.ring.size() < capacity) {
+        trail.ring.push_back(pt); // within the capacity reserved by clear()
+        return;
+    }
+
+    trail.ring[trail.head] = pt;
+    trail.head = (trail.head + 1) % trail.ring.size();
+
+    // Bounds only ever grow between wraps; refit them once per full lap so
+    // evicted history stops inflating them (amortised O(1) per commit).
+    if (trail.head == 0) {
+        float minX = pt.p.getX(), maxX = minX, minY = pt.p.getY(), maxY = minY;
+        for (const auto& q : trail.ring) {
+            minX = std::min(minX, q.p.getX()); maxX = std::max(maxX, q.p.getX());
+            minY = std::min(minY, q.p.getY()); maxY = std::max(maxY, q.p.getY());
+        }
+        for (const auto& q : trail.pending) {
+            minX = std::min(minX, q.p.getX()); maxX = std::max(maxX, q.p.getX());
+            minY = std::min(minY, q.p.getY()); maxY = std::max(maxY, q.p.getY());
+        }
+        trail.minX = minX; trail.maxX = maxX; trail.minY = minY; trail.maxY = maxY;
+    }
+}
+
+bool TrailRecorder::chordFits(const Trail& trail, const TrailPoint& end) const {
+    const TrailPoint& start = trail.committed(trail.ring.size() - 1);
+    const float ax = start.p.getX(), ay = start.p.getY();
+    const float dx = end.p.getX() - ax, dy = end.p.getY() - ay;
+    const float len2 = dx * dx + dy * dy;
+    const float tol2 = tolerance * tolerance;
+
+    for (const auto& q : trail.pending) {
+        const float qx = q.p.getX() - ax, qy = q.p.getY() - ay;
+        float dist2;
+        if (len2 <= 0.0f) {
+            dist2 = qx * qx + qy * qy;
+        } else {
+            // Squared perpendicular distance to the chord, clamped to its endpoints
+            const float s = std::clamp((qx * dx + qy * dy) / len2, 0.0f, 1.0f);
+            const float ex = qx - s * dx, ey = qy - s * dy;
+            dist2 = ex * ex + ey * ey;
+        }
+        if (dist2 > tol2) return false;
+    }
+    return true;
+}
@@ -0,0 +1,91 @@
+// Shared body of the per-ISA kernel translation units. Each includes this once, after
+// deciding PLANETS_KERNEL_SIMD, and is compiled with its own -m flags; everything here
+// has internal linkage so the copies never mix.
+#ifndef KERNEL_IMPL_HPP
+#define KERNEL_IMPL_HPP
+
+#include <cmath>
+#include "planets/Kernels.hpp"
+
+#define PLANETS_KERNEL_PRAGMA(x) _Pragma(#x)
+#if PLANETS_KERNEL_SIMD
+// Reordering float sums is what lets the reductions vectorise (-fopenmp-simd)
+#define PLANETS_SIMD PLANETS_KERNEL_PRAGMA(omp simd)
+#define PLANETS_SIMD_REDUCTION(...) PLANETS_KERNEL_PRAGMA(omp simd reduction(+ : __VA_ARGS__))
+#else
+#define PLANETS_SIMD
+#define PLANETS_SIMD_REDUCTION(...)
+#endif
+
+namespace {
+
+void forces(const float* x, const float* y, const float* m, float* ax, float* ay, std::size_t n, float g,
+            float eps2) {
+    // Each pair once: body i gathers its sum, the partners j > i are updated in place
+    for (std::size_t i = 0; i < n; ++i) {
+        const float xi = x[i], yi = y[i], mi = m[i];
+        float axi = 0.0f, ayi = 0.0f;
+        PLANETS_SIMD_REDUCTION(axi, ayi)
+        for (std::size_t j = i + 1; j < n; ++j) {
+            const float dx = x[j] - xi, dy = y[j] - yi;
+            const float d2 = dx * dx + dy * dy;
+            const float dist = std::sqrt(d2);
+            // |F| / (m_i m_j |r|); selects rather than a branch around the division keep
+            // the loop vectorisable
+            const float q = dist * (d2 + eps2);
+            const float s = (dist > 0.0f ? g : 0.0f) / (q > 0.0f ? q : 1.0f);
+            axi += m[j] * s * dx;
+            ayi += m[j] * s * dy;
+            ax[j] -= mi * s * dx;
+            ay[j] -= mi * s * dy;
+        }
+        ax[i] += axi;
+        ay[i] += ayi;
+    }
+}
+
+void integrate(float* x, float* y, float* vx, float* vy, const float* ax, const float* ay, std::size_t n,
+               float dt) {
+    PLANETS_SIMD
+    for (std::size_t i = 0; i < n; ++i) {
+        vx[i] += ax[i] * dt;
+        vy[i] += ay[i] * dt;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+    }
+}
+
+void sums(const float* x, const float* y, const float* vx, const float* vy, const float* m, std::size_t n,
+          double* out) {
+    double mass = 0.0, mx = 0.0, my = 0.0, px = 0.0, py = 0.0;
+    PLANETS_SIMD_REDUCTION(mass, mx, my, px, py)
+    for (std::size_t i = 0; i < n; ++i) {
+        const double mi = m[i] > 0.0f ? static_cast<double>(m[i]) : 0.0;
+        mass += mi;
+        mx += mi * x[i];
+        my += mi * y[i];
+        px += mi * vx[i];
+        py += mi * vy[i];
+    }
+    out[0] = mass;
+    out[1] = mx;
+    out[2] = my;
+    out[3] = px;
+    out[4] = py;
+}
+
+void packPositions(const float* x, const float* y, std::size_t n, float* dst) {
+    PLANETS_SIMD
+    for (std::size_t i = 0; i < n; ++i) {
+        dst[2 * i] = x[i];
+        dst[2 * i + 1] = y[i];
+    }
+}
+
+}
+
+#define PLANETS_KERNEL_TABLE(isa) \
+    static const kernels::Table table{ isa, &forces, &integrate, &sums, &packPositions }; \
+    return &table
+
+#endif // KERNEL_IMPL_HPP
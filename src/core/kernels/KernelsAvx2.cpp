@@ -0,0 +1,15 @@
+// Built with -mavx2 -mfma (see CMakeLists.txt); without them the table is left out
+#if defined(__AVX2__) && defined(__FMA__)
+#define PLANETS_KERNEL_SIMD 1
+#include "KernelImpl.hpp"
+
+const kernels::Table* kernels::detail::avx2Table() {
+    PLANETS_KERNEL_TABLE(kernels::Isa::AVX2);
+}
+#else
+#include "planets/Kernels.hpp"
+
+const kernels::Table* kernels::detail::avx2Table() {
+    return nullptr;
+}
+#endif
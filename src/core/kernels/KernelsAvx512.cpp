@@ -0,0 +1,15 @@
+// Built with -mavx512f -mavx512vl -mavx512dq -mavx512bw (see CMakeLists.txt); without them the table is left out
+#if defined(__AVX512F__) && defined(__AVX512VL__)
+#define PLANETS_KERNEL_SIMD 1
+#include "KernelImpl.hpp"
+
+const kernels::Table* kernels::detail::avx512Table() {
+    PLANETS_KERNEL_TABLE(kernels::Isa::AVX512);
+}
+#else
+#include "planets/Kernels.hpp"
+
+const kernels::Table* kernels::detail::avx512Table() {
+    return nullptr;
+}
+#endif
@@ -0,0 +1,7 @@
+// Reference kernels: plain loops in the baseline instruction set
+#define PLANETS_KERNEL_SIMD 0
+#include "KernelImpl.hpp"
+
+const kernels::Table* kernels::detail::scalarTable() {
+    PLANETS_KERNEL_TABLE(kernels::Isa::Scalar);
+}
@@ -0,0 +1,15 @@
+// Built with -msse4.2 (see CMakeLists.txt); without them the table is left out
+#if defined(__SSE4_2__)
+#define PLANETS_KERNEL_SIMD 1
+#include "KernelImpl.hpp"
+
+const kernels::Table* kernels::detail::sse4Table() {
+    PLANETS_KERNEL_TABLE(kernels::Isa::SSE4);
+}
+#else
+#include "planets/Kernels.hpp"
+
+const kernels::Table* kernels::detail::sse4Table() {
+    return nullptr;
+}
+#endif
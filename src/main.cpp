@@ -1,7 +1,12 @@
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <cmath>
 #include <random>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "planets/Renderer.hpp"
@@ -10,29 +15,444 @@
 #include "planets/Camera.hpp"
 #include "planets/Simulation.hpp"
 #include "planets/GUI.hpp"
+#include "planets/Picker.hpp"
+#include "planets/Profiler.hpp"
+#include "planets/PerfCounters.hpp"
+#include "planets/MemoryTracker.hpp"
+#include "planets/FrameTelemetry.hpp"
+#include "planets/Diagnostics.hpp"
+#include "planets/Kernels.hpp"
+#include "planets/MetricsServer.hpp"
+#include "planets/FrameCapture.hpp"
+#include "planets/SoftwareRenderer.hpp"
+#include "planets/ImageWriter.hpp"
 
 using namespace std;
 
-int main() {
-    Renderer renderer(1280, 720, "Planetary Simulation");
+// Command-line options (interactive by default)
+struct Options {
+    bool headless = false;
+    bool software = false;
+    int width = 1280;
+    int height = 720;
+    int frames = 600;
+    int fps = 60;
+    int bodies = 12;
+    unsigned seed = 1337;
+    string capturePath;
+    double compareTolerance = -1.0; // --compare-software: worst mean difference allowed
+    string shaderDir;
+    string tracePath;
+    int traceFrames = 300;
+    int traceSkip = 0;
+    bool perfCounters = false;
+    string isa;
+    int allocationWarmup = -1; // --assert-no-alloc
+    string frameCsvPath;
+    string metricsSocket;
+};
+
+static bool parseOptions(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const string arg = argv[i];
+        auto next = [&](const char* name) -> const char* {
+            if (i + 1 >= argc) {
+                cerr << "Missing value for " << name << "\n";
+                return nullptr;
+            }
+            return argv[++i];
+        };
+        const char* v = nullptr;
+        if (arg == "--headless") {
+            opt.headless = true;
+        } else if (arg == "--software") {
+            opt.headless = true;
+            opt.software = true;
+        } else if (arg == "--compare-software") {
+            if (!(v = next("--compare-software"))) return false;
+            opt.headless = true;
+            opt.compareTolerance = max(0.0, atof(v));
+        } else if (arg == "--capture") {
+            if (!(v = next("--capture"))) return false;
+            opt.capturePath = v;
+        } else if (arg == "--shader-dir") {
+            if (!(v = next("--shader-dir"))) return false;
+            opt.shaderDir = v;
+        } else if (arg == "--trace") {
+            if (!(v = next("--trace"))) return false;
+            opt.tracePath = v;
+        } else if (arg == "--trace-frames") {
+            if (!(v = next("--trace-frames"))) return false;
+            opt.traceFrames = max(1, atoi(v));
+        } else if (arg == "--trace-skip") {
+            if (!(v = next("--trace-skip"))) return false;
+            opt.traceSkip = max(0, atoi(v));
+        } else if (arg == "--perf-counters") {
+            opt.perfCounters = true;
+        } else if (arg == "--isa") {
+            if (!(v = next("--isa"))) return false;
+            opt.isa = v;
+        } else if (arg == "--metrics-socket") {
+            if (!(v = next("--metrics-socket"))) return false;
+            opt.metricsSocket = v;
+        } else if (arg == "--frame-csv") {
+            if (!(v = next("--frame-csv"))) return false;
+            opt.frameCsvPath = v;
+        } else if (arg == "--assert-no-alloc") {
+            if (!(v = next("--assert-no-alloc"))) return false;
+            opt.allocationWarmup = max(0, atoi(v));
+        } else if (arg == "--frames") {
+            if (!(v = next("--frames"))) return false;
+            opt.frames = max(1, atoi(v));
+        } else if (arg == "--fps") {
+            if (!(v = next("--fps"))) return false;
+            opt.fps = max(1, atoi(v));
+        } else if (arg == "--bodies") {
+            if (!(v = next("--bodies"))) return false;
+            opt.bodies = max(1, atoi(v));
+        } else if (arg == "--seed") {
+            if (!(v = next("--seed"))) return false;
+            opt.seed = static_cast<unsigned>(strtoul(v, nullptr, 10));
+        } else if (arg == "--size") {
+            if (!(v = next("--size"))) return false;
+            if (sscanf(v, "%dx%d", &opt.width, &opt.height) != 2 || opt.width <= 0 || opt.height <= 0) {
+                cerr << "Expected --size WIDTHxHEIGHT\n";
+                return false;
+            }
+        } else {
+            cerr << "Unknown option " << arg << "\n"
+                 << "Usage: PlanetsProject [--headless|--software] [--capture out.y4m|out.png|out.rgba]\n"
+                 << "                      [--compare-software MEAN_ABS]\n"
+                 << "                      [--frames N] [--fps N] [--size WxH] [--bodies N] [--seed S]\n"
+                 << "                      [--shader-dir DIR] [--trace out.json [--trace-frames N] [--trace-skip N]]\n"
+                 << "                      [--perf-counters] [--assert-no-alloc WARMUP_STEPS] [--frame-csv out.csv]\n"
+                 << "                      [--metrics-socket PATH] [--isa scalar|sse4|avx2|avx512]\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Batch runs report the kernel counters collected over the whole run
+static void printPerfCounters() {
+    const PerfCounters& pc = PerfCounters::get();
+    if (!pc.isEnabled()) return;
+    cout << pc.summary(PerfCounters::Forces) << "\n" << pc.summary(PerfCounters::Integrate) << "\n";
+}
+
+// Opens the Prometheus endpoint if requested; a failure is reported but not fatal
+static void startMetrics(MetricsServer& metrics, const Options& opt) {
+    if (opt.metricsSocket.empty()) return;
+    if (metrics.start(opt.metricsSocket)) {
+        cout << "Serving metrics on unix:" << opt.metricsSocket << "\n";
+    } else {
+        cerr << "Metrics endpoint unavailable: " << metrics.getError() << "\n";
+    }
+}
+
+static double wallSeconds() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Batch runs print frame-time percentiles and optionally write every frame as CSV
+static void reportFrameTimes(const FrameTelemetry& telemetry, const Options& opt) {
+    cout << telemetry.summary();
+    if (!opt.frameCsvPath.empty() && telemetry.exportCsv(opt.frameCsvPath)) {
+        cout << "Wrote frame times to " << opt.frameCsvPath << "\n";
+    }
+}
+
+// Batch runs end with the conserved quantities of the final state
+static void reportDiagnostics(Diagnostics& diagnostics, const Simulation& sim) {
+    diagnostics.flush(sim);
+    if (!diagnostics.hasSample()) return;
+    const Diagnostics::Sample& s = diagnostics.getLatest();
+    char line[200];
+    snprintf(line, sizeof(line),
+             "Conserved quantities at t=%.3f: E %.6g (drift %.2e), momentum drift %.2e, "
+             "angular momentum drift %.2e, virial 2K/|U| %.4f\n",
+             s.simTime, s.energy, s.energyDrift, s.momentumDrift, s.angularDrift, s.virialRatio);
+    cout << line;
+}
+
+// Batch runs also report what each subsystem holds at the end of the run
+static void printMemory(const MemoryTracker::Report& report) {
+    MemoryTracker::Report full = report;
+    full.addCpu(MemoryTracker::IO, Tracer::get().memoryBytes());
+    cout << "Memory by subsystem:\n" << MemoryTracker::summary(full);
+}
+
+// Offscreen run: fixed sim time per frame, frames streamed to disk without a window
+static int runHeadless(const Options& opt) {
+    Renderer renderer(opt.width, opt.height, "Planetary Simulation");
+    renderer.setHeadless(true);
+    if (!opt.shaderDir.empty()) renderer.getShaderCache().setSourceDir(opt.shaderDir);
     if (!renderer.init()) {
         return -1;
     }
 
-    Camera camera(1280.0f, 720.0f);
+    Camera camera(static_cast<float>(opt.width), static_cast<float>(opt.height));
+    Simulation sim;
+    sim.setGravityParams(0.05f, 0.02f);
+    sim.setTimeStep(0.0015f);
+    sim.initRandom(opt.bodies, opt.seed);
+    sim.setAllocationCheck(opt.allocationWarmup);
+
+    FrameCapture capture;
+    if (!opt.capturePath.empty() && !capture.start(opt.capturePath, opt.width, opt.height, opt.fps)) {
+        renderer.cleanup();
+        return -1;
+    }
+
+    // --compare-software: each frame is also rasterized on the CPU and diffed against a
+    // readback of the GL frame. The CPU path has no density view, so sprites are forced.
+    unique_ptr<SoftwareRenderer> reference;
+    vector<uint8_t> readback;
+    SoftwareRenderer::ImageDiff worst;
+    int worstFrame = -1;
+    if (opt.compareTolerance >= 0.0) {
+        reference = make_unique<SoftwareRenderer>(opt.width, opt.height);
+        renderer.setPlanetRenderMode(PlanetRenderMode::Sprites);
+    }
+
+    const float frameDt = 1.0f / static_cast<float>(opt.fps);
+    double accumulator = 0.0;
+    FrameTelemetry telemetry;
+    Diagnostics diagnostics;
+    MetricsServer metrics;
+    startMetrics(metrics, opt);
+    renderer.setViewportRect(0, 0, opt.width, opt.height);
+    for (int frame = 0; frame < opt.frames; ++frame) {
+        Tracer::get().beginFrame();
+        telemetry.beginFrame();
+        accumulator += frameDt;
+        {
+            PLANETS_PROFILE_SCOPE("Physics");
+            FrameTelemetry::Scope timed(telemetry, FrameTelemetry::Physics);
+            while (accumulator >= sim.getTimeStep()) {
+                sim.step();
+                accumulator -= sim.getTimeStep();
+            }
+        }
+        {
+            PLANETS_PROFILE_SCOPE("Camera");
+            camera.update(sim, frameDt);
+        }
+
+        {
+            FrameTelemetry::Scope timed(telemetry, FrameTelemetry::Render);
+            renderer.beginFrame();
+            renderer.beginScene();
+            renderer.drawBackground(camera);
+            renderer.drawTrails(sim.getTrails(), sim.getPlanets(), camera);
+            renderer.drawPlanets(sim, camera);
+            renderer.endScene();
+            capture.capture(renderer.getSceneFramebuffer());
+        }
+        if (reference) {
+            PLANETS_PROFILE_SCOPE("Compare software");
+            renderer.readScenePixels(readback);
+            reference->render(sim, camera);
+            const SoftwareRenderer::ImageDiff diff =
+                SoftwareRenderer::compare(readback.data(), reference->getPixels().data(), opt.width, opt.height);
+            if (worstFrame < 0 || diff.meanAbs > worst.meanAbs) {
+                worst = diff;
+                worstFrame = frame;
+            }
+        }
+        renderer.endFrame();
+        telemetry.endFrame();
+        const double wall = wallSeconds();
+        diagnostics.update(sim, wall);
+        if (metrics.publish(sim, wall)) {
+            MemoryTracker::Report memory;
+            sim.collectMemory(memory);
+            renderer.collectMemory(memory);
+            memory.addCpu(MemoryTracker::SpatialIndex, diagnostics.memoryBytes());
+            capture.collectMemory(memory);
+            metrics.publishMemory(memory);
+            metrics.publishFrameTimes(telemetry);
+            if (diagnostics.hasSample()) metrics.publishDiagnostics(diagnostics.getLatest());
+            metrics.publishCaptureQueue(capture.getWriterQueueDepth(), capture.getPendingReadbacks());
+        }
+        Tracer::get().endFrame();
+    }
+    Tracer::get().finish();
+    printPerfCounters();
+    reportFrameTimes(telemetry, opt);
+    reportDiagnostics(diagnostics, sim);
+    MemoryTracker::Report memory;
+    sim.collectMemory(memory);
+    renderer.collectMemory(memory);
+    memory.addCpu(MemoryTracker::SpatialIndex, diagnostics.memoryBytes());
+    capture.collectMemory(memory);
+    printMemory(memory);
+
+    capture.finish();
+    if (capture.getFramesCaptured() > 0) {
+        cout << "Captured " << capture.getFramesCaptured() << " frames to " << opt.capturePath << "\n";
+    }
+    renderer.cleanup();
+
+    bool matched = true;
+    if (worstFrame >= 0) {
+        matched = worst.meanAbs <= opt.compareTolerance;
+        char line[200];
+        snprintf(line, sizeof(line),
+                 "GL vs software over %d frames: worst frame %d, mean abs %.3f (limit %.3f), max abs %d, "
+                 "PSNR %.1f dB%s\n",
+                 opt.frames, worstFrame, worst.meanAbs, opt.compareTolerance, worst.maxAbs, worst.psnr,
+                 matched ? "" : "  MISMATCH");
+        cout << line;
+    }
+    return matched ? 0 : 2;
+}
+
+// Headless run on the CPU rasterizer: no GL context or GPU needed
+static int runSoftware(const Options& opt) {
+    Camera camera(static_cast<float>(opt.width), static_cast<float>(opt.height));
+    Simulation sim;
+    sim.setGravityParams(0.05f, 0.02f);
+    sim.setTimeStep(0.0015f);
+    sim.initRandom(opt.bodies, opt.seed);
+    sim.setAllocationCheck(opt.allocationWarmup);
+
+    ImageSequenceWriter writer;
+    if (!opt.capturePath.empty() &&
+        !writer.open(opt.capturePath, ImageSequenceWriter::formatFromPath(opt.capturePath), opt.width, opt.height, opt.fps)) {
+        return -1;
+    }
+
+    SoftwareRenderer renderer(opt.width, opt.height);
+    const float frameDt = 1.0f / static_cast<float>(opt.fps);
+    double accumulator = 0.0;
+    FrameTelemetry telemetry;
+    Diagnostics diagnostics;
+    MetricsServer metrics;
+    startMetrics(metrics, opt);
+    for (int frame = 0; frame < opt.frames; ++frame) {
+        Tracer::get().beginFrame();
+        telemetry.beginFrame();
+        accumulator += frameDt;
+        {
+            PLANETS_PROFILE_SCOPE("Physics");
+            FrameTelemetry::Scope timed(telemetry, FrameTelemetry::Physics);
+            while (accumulator >= sim.getTimeStep()) {
+                sim.step();
+                accumulator -= sim.getTimeStep();
+            }
+        }
+        {
+            PLANETS_PROFILE_SCOPE("Camera");
+            camera.update(sim, frameDt);
+        }
+
+        {
+            PLANETS_PROFILE_SCOPE("Rasterize");
+            FrameTelemetry::Scope timed(telemetry, FrameTelemetry::Render);
+            renderer.render(sim, camera);
+        }
+        if (writer.isOpen()) {
+            PLANETS_PROFILE_SCOPE("Encode frame");
+            // Rows are bottom-up like a GL readback
+            writer.writeFrame(renderer.getPixels().data(), static_cast<size_t>(opt.width) * 4, true);
+        }
+        telemetry.endFrame();
+        const double wall = wallSeconds();
+        diagnostics.update(sim, wall);
+        if (metrics.publish(sim, wall)) {
+            MemoryTracker::Report memory;
+            sim.collectMemory(memory);
+            renderer.collectMemory(memory);
+            memory.addCpu(MemoryTracker::SpatialIndex, diagnostics.memoryBytes());
+            memory.addCpu(MemoryTracker::IO, writer.memoryBytes());
+            metrics.publishMemory(memory);
+            metrics.publishFrameTimes(telemetry);
+            if (diagnostics.hasSample()) metrics.publishDiagnostics(diagnostics.getLatest());
+        }
+        Tracer::get().endFrame();
+    }
+    Tracer::get().finish();
+    printPerfCounters();
+    reportFrameTimes(telemetry, opt);
+    reportDiagnostics(diagnostics, sim);
+    MemoryTracker::Report memory;
+    sim.collectMemory(memory);
+    renderer.collectMemory(memory);
+    memory.addCpu(MemoryTracker::SpatialIndex, diagnostics.memoryBytes());
+    memory.addCpu(MemoryTracker::IO, writer.memoryBytes());
+    printMemory(memory);
+
+    if (writer.getFramesWritten() > 0) {
+        cout << "Rendered " << writer.getFramesWritten() << " frames to " << opt.capturePath << "\n";
+    }
+    writer.close();
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        return 1;
+    }
+    Tracer::get().setThreadName("Main");
+    if (!opt.isa.empty()) {
+        kernels::Isa isa;
+        if (!kernels::parseIsa(opt.isa.c_str(), isa)) {
+            cerr << "Unknown ISA " << opt.isa << ", using " << kernels::isaName(kernels::active().isa) << "\n";
+        } else if (!kernels::select(isa)) {
+            cerr << kernels::isaName(isa) << " kernels not available here, using "
+                 << kernels::isaName(kernels::active().isa) << "\n";
+        }
+    }
+    if (opt.perfCounters && !PerfCounters::get().setEnabled(true)) {
+        cerr << "Hardware counters unavailable: " << PerfCounters::get().getError() << "\n";
+    }
+    if (!opt.tracePath.empty()) {
+        Tracer::get().capture(opt.tracePath, opt.traceFrames, opt.traceSkip);
+    }
+    if (opt.allocationWarmup >= 0 && !MemoryTracker::isTracking()) {
+        cerr << "--assert-no-alloc needs a build with -DPLANETS_ALLOCATION_TRACKING=ON; ignoring\n";
+    }
+    if (opt.software) {
+        return runSoftware(opt);
+    }
+    if (opt.headless) {
+        return runHeadless(opt);
+    }
+    if (!opt.capturePath.empty()) {
+        cerr << "--capture is only supported together with --headless\n";
+    }
+
+    Renderer renderer(opt.width, opt.height, "Planetary Simulation");
+    if (!opt.shaderDir.empty()) renderer.getShaderCache().setSourceDir(opt.shaderDir);
+    if (!renderer.init()) {
+        return -1;
+    }
+
+    Camera camera(static_cast<float>(opt.width), static_cast<float>(opt.height));
 
     // Initialize GUI
     GUI gui;
     if (!gui.init(renderer.getWindow())) {
         return -1;
     }
+    Picker picker;
+    Selection selection;
+    gui.setSelection(&selection);
+    FrameTelemetry telemetry;
+    gui.setTelemetry(&telemetry);
+    Diagnostics diagnostics;
+    gui.setDiagnostics(&diagnostics);
+    MetricsServer metrics;
+    startMetrics(metrics, opt);
 
     // Create simulation and initial random bodies
     Simulation sim;
     sim.setGravityParams(0.05f, 0.02f);
     sim.setTimeStep(0.0015f);
-    const int N = 12;
-    sim.initRandom(N, 1337);
+    sim.initRandom(opt.bodies, opt.seed);
+    sim.setAllocationCheck(opt.allocationWarmup);
 
     float physicsTimeStep = 0.0016f;
     double lastTime = glfwGetTime();
@@ -43,6 +463,9 @@ int main() {
         double now = glfwGetTime();
         float deltaTime = static_cast<float>(now - lastTime);
         lastTime = now;
+        Profiler::get().beginFrame();
+        Tracer::get().beginFrame();
+        telemetry.beginFrame();
 
     // Handle input
     GLFWwindow* window = renderer.getWindow();
@@ -71,46 +494,55 @@ int main() {
             renderer.handleInput();
         }
 
-        // Double-click to follow planet (only if not captured by GUI)
-        if (!guiCapturesMouse) {
+        // Mouse picking goes through the spatial index. The cursor is in window
+        // coordinates; the picker works in framebuffer pixels like the viewport.
+        float yscale = (winH > 0) ? (float)fbH / (float)winH : 1.0f;
+        picker.setViewport((float)simLeft, 0.0f, (float)simWidth, (float)simHeight);
+        picker.setSpriteScale(renderer.getPlanetVisualScale());
+        double xpos = 0.0, ypos = 0.0;
+        glfwGetCursorPos(window, &xpos, &ypos);
+        const glm::vec2 cursor((float)xpos, (float)ypos);
+        const glm::vec2 cursorPx(cursor.x * xscale, cursor.y * yscale);
+        const bool cursorInView = picker.contains(cursorPx);
+
+        // Hover: body under the cursor, shown by the GUI tooltip
+        selection.hovered = -1;
+        if (!guiCapturesMouse && cursorInView && !selection.dragging) {
+            PLANETS_PROFILE_SCOPE("Picking");
+            selection.hovered = picker.pickNearest(sim, camera, cursorPx, 6.0f);
+        }
+
+        // Double-click follows a planet; Shift+drag box-selects (only if not captured by GUI)
+        static bool mouseButtonWasPressed = false;
+        bool mouseButtonPressed = (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS);
+        if (selection.dragging) {
+            selection.dragEnd = cursor;
+            if (!mouseButtonPressed) {
+                selection.dragging = false;
+                selection.selected.clear();
+                const glm::vec2 a(selection.dragStart.x * xscale, selection.dragStart.y * yscale);
+                // Shift+click without a drag clears the selection
+                if (glm::length(cursorPx - a) > 3.0f) {
+                    picker.pickRect(sim, camera, a, cursorPx, selection.selected);
+                }
+            }
+        } else if (!guiCapturesMouse && cursorInView) {
             static double lastClickTime = 0.0;
             static const double doubleClickDelay = 0.3; // 300ms
-            
-            static bool mouseButtonWasPressed = false;
-            bool mouseButtonPressed = (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS);
-            
-            if (mouseButtonPressed && !mouseButtonWasPressed) {
+            const bool shiftHeld = glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
+                                   glfwGetKey(window, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
+
+            if (mouseButtonPressed && !mouseButtonWasPressed && shiftHeld) {
+                selection.dragging = true;
+                selection.dragStart = selection.dragEnd = cursor;
+                lastClickTime = 0.0;
+            } else if (mouseButtonPressed && !mouseButtonWasPressed) {
                 // Mouse button just pressed
                 double currentTime = glfwGetTime();
                 if (currentTime - lastClickTime < doubleClickDelay) {
-                    // Double-click detected!
-                    double xpos, ypos;
-                    glfwGetCursorPos(window, &xpos, &ypos);
-                    
-                    // Convert screen coordinates to world coordinates
-                    // Account for GUI panel offset
-                    float xNorm = ((float)xpos - (float)gui.getPanelWidth()) / (float)(winW - gui.getPanelWidth());
-                    float yNorm = (float)ypos / (float)winH;
-                    
-                    // Convert to NDC [-1, 1]
-                    float ndcX = xNorm * 2.0f - 1.0f;
-                    float ndcY = 1.0f - yNorm * 2.0f; // flip Y
-                    
-                    // Convert to world space
-                    glm::vec2 worldPos = camera.getPosition() + glm::vec2(ndcX, ndcY) / camera.getZoom();
-                    
-                    // Find closest planet
-                    int closestIndex = -1;
-                    float closestDist = std::numeric_limits<float>::max();
-                    for (int i = 0; i < sim.getPlanets().size(); ++i) {
-                        const Planet& p = sim.getPlanets()[i];
-                        glm::vec2 planetPos(p.getP().getX(), p.getP().getY());
-                        float dist = glm::length(worldPos - planetPos);
-                        if (dist < closestDist) {
-                            closestDist = dist;
-                            closestIndex = i;
-                        }
-                    }
+                    // Double-click detected: prefer the body drawn under the cursor,
+                    // otherwise the closest one
+                    const int closestIndex = picker.pickClosest(sim, camera, cursorPx, 8.0f);
                     
                     // Toggle follow mode
                     if (closestIndex >= 0) {
@@ -128,8 +560,8 @@ int main() {
                     lastClickTime = currentTime;
                 }
             }
-            mouseButtonWasPressed = mouseButtonPressed;
         }
+        mouseButtonWasPressed = mouseButtonPressed;
 
     // GUI toggle (H) should always be available
         
@@ -153,7 +585,7 @@ int main() {
             
             static bool cKeyPressed = false;
             if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS && !cKeyPressed) {
-                renderer.clearTrails();
+                sim.clearTrails();
                 cKeyPressed = true;
             } else if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE) {
                 cKeyPressed = false;
@@ -165,10 +597,13 @@ int main() {
             static double accumulator = 0.0;
             if (gui.wasRestartTriggered()) {
                 accumulator = 0.0; // avoid heavy catch-up after restart
+                selection.clear(); // indices refer to the old bodies
                 gui.clearRestartFlag();
             }
 
             if (!gui.isSimulationPaused()) {
+                PLANETS_PROFILE_SCOPE("Physics");
+                FrameTelemetry::Scope timed(telemetry, FrameTelemetry::Physics);
                 const float baseSimDt = sim.getTimeStep();
                 accumulator += deltaTime;
 
@@ -191,7 +626,20 @@ int main() {
         }
 
         // Camera follows simulation planets
-        camera.update(sim.getPlanets(), deltaTime);
+        {
+            PLANETS_PROFILE_SCOPE("Camera");
+            camera.update(sim, deltaTime);
+        }
+        diagnostics.update(sim, now);
+        if (metrics.publish(sim, now)) {
+            MemoryTracker::Report memory;
+            sim.collectMemory(memory);
+            renderer.collectMemory(memory);
+            memory.addCpu(MemoryTracker::SpatialIndex, diagnostics.memoryBytes());
+            metrics.publishMemory(memory);
+            metrics.publishFrameTimes(telemetry);
+            if (diagnostics.hasSample()) metrics.publishDiagnostics(diagnostics.getLatest());
+        }
         // Manual camera controls (only when GUI is not capturing keyboard input)
         if (!guiCapturesKeyboard) {
             if (glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS) {
@@ -216,24 +664,47 @@ int main() {
             }
         }
         
+        // Render on demand: skip the frame entirely while minimized or when nothing
+        // visible changed, sleeping until the next event instead of spinning
+        if (renderer.isMinimized()) {
+            // Keep a running simulation advancing at roughly display rate
+            renderer.waitEvents(gui.isSimulationPaused() ? 0.5 : 1.0 / 60.0);
+            telemetry.discardFrame();
+            continue;
+        }
+        if (!renderer.needsRedraw(sim, camera)) {
+            renderer.waitEvents(0.25);
+            telemetry.discardFrame();
+            continue;
+        }
+
         // Render
-        gui.newFrame();
-
-        renderer.beginFrame();
-        // Set viewport for simulation drawing (right pane)
-        glViewport(simLeft, simBottom, simWidth, simHeight);
-        renderer.drawBackground(camera);
-        renderer.drawTrails(sim.getPlanets(), camera);
-        renderer.drawPlanets(sim.getPlanets(), camera);
-        
-        // Reset viewport to full window for GUI draw
-        glViewport(0, 0, fbW, fbH);
-        gui.render(sim, camera, renderer, deltaTime);
+        {
+            FrameTelemetry::Scope timed(telemetry, FrameTelemetry::Render);
+            gui.newFrame();
+
+            renderer.beginFrame();
+            // Simulation pane, possibly at reduced resolution and upscaled into the viewport
+            renderer.beginScene();
+            renderer.drawBackground(camera);
+            renderer.drawTrails(sim.getTrails(), sim.getPlanets(), camera);
+            renderer.drawPlanets(sim, camera);
+            // Restores the full-window viewport; the GUI draws at native resolution
+            renderer.endScene();
+            gui.render(sim, camera, renderer, deltaTime);
+        }
     
+        renderer.markDrawn(sim, camera);
+        // Presents, then polls the events the next frame reacts to
         renderer.endFrame();
+        telemetry.endFrame();
+        Profiler::get().endFrame();
+        Tracer::get().endFrame();
         time += deltaTime;
     }
     
+    // Write out a trace window that was still recording
+    Tracer::get().finish();
     gui.shutdown();
     renderer.cleanup();
     return 0;